@@ -9,6 +9,12 @@
 #include <algorithm>
 #include <numeric>
 #include <functional>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "Config.hpp"
 
 #define pi_d 1/3.14159265359
 
@@ -28,145 +34,280 @@ namespace ml {
         static constexpr bool const value = is_stl_container_impl::is_stl_container<std::decay_t<T>>::value;
     };
 
-    /** Base function that performs arithmatics with scalars. 
+    template <typename OP, typename L, typename R>
+    struct array_expression;
+
+    // Type trait to test if type is an unevaluated array expression.
+    template <typename T>                               struct is_array_expression:std::false_type{};
+    template <typename OP, typename L, typename R>      struct is_array_expression<array_expression<OP, L, R>>:std::true_type{};
+
+    // Type trait to test if type can be indexed as an array (STL container or array expression).
+    template <typename T> struct is_array_like {
+        static constexpr bool const value = is_stl_container<T>::value or is_array_expression<std::decay_t<T>>::value;
+    };
+
+    namespace detail {
+        // Value type and size known at compile time (0 for dynamic containers) of an operand.
+        template <typename T, typename = void>
+        struct operand_traits {
+            using value_type = std::decay_t<T>;
+            static constexpr size_t size = 0;
+        };
+
+        template <typename T>                               struct static_size:std::integral_constant<size_t, 0>{};
+        template <typename T, std::size_t N>                struct static_size<std::array<T, N>>:std::integral_constant<size_t, N>{};
+        template <typename OP, typename L, typename R>      struct static_size<array_expression<OP, L, R>>:
+                                                                std::integral_constant<size_t, array_expression<OP, L, R>::static_size>{};
+
+        template <typename T>
+        struct operand_traits<T, std::enable_if_t<is_array_like<T>::value>> {
+            using value_type = typename std::decay_t<T>::value_type;
+            static constexpr size_t size = static_size<std::decay_t<T>>::value;
+        };
+
+        // Operands which are lvalues are stored by reference, temporaries are stored by value.
+        template <typename T>
+        using stored_t = std::conditional_t<std::is_lvalue_reference<T>::value and is_stl_container<T>::value, 
+                                            const std::decay_t<T>&, std::decay_t<T>>;
+
+        template <typename S>
+        constexpr std::enable_if_t<std::is_arithmetic<S>::value, S> element(const S& s, size_t) { return s; }
+
+        template <typename A>
+        constexpr auto element(const A& a, size_t i) -> decltype(a[i]) { return a[i]; }
+
+        template <typename S>
+        constexpr std::enable_if_t<std::is_arithmetic<S>::value, size_t> length(const S&) { return 0; }
+
+        template <typename A>
+        constexpr auto length(const A& a) -> decltype(a.size()) { return a.size(); }
+    }
+
+    /** Unevaluated element wise operation of two operands, of which at least one is array like. 
+     * Each element is only calculated when it is read, so nested expressions evaluate in a single 
+     * loop without intermediate arrays. The expression converts to the array type of its operands.
      * 
      * Template arguments:
-     * @param OP    Type of the arithmatic function pointer (e.g. std::plus, std::minus etc.)
-     * @param A     Type of the results which should be an enumeration.
-     * @param T     Type of the scalar.
+     * @param OP    Type of the arithmatic function object (e.g. std::plus, std::minus etc.)
+     * @param L     Type of the left operand, a const reference for lvalue arrays.
+     * @param R     Type of the right operand, a const reference for lvalue arrays.
      */
-    template<template < class > class OP, typename A, typename T>
-    std::enable_if_t<std::is_arithmetic<T>::value, void> math (A& a, T t) {
-        std::for_each(a.begin(), a.end(), [&](auto& i){
-            i = OP<T>()(i, t);
-        });
+    template <typename OP, typename L, typename R>
+    struct array_expression {
+        using value_type = std::conditional_t<is_array_like<L>::value, 
+                                              typename detail::operand_traits<L>::value_type, 
+                                              typename detail::operand_traits<R>::value_type>;
+        static constexpr size_t static_size = is_array_like<L>::value ? detail::operand_traits<L>::size : 
+                                                                       detail::operand_traits<R>::size;
+
+        L l;
+        R r;
+
+        constexpr value_type operator[](size_t i) const {
+            return OP()(detail::element(l, i), detail::element(r, i));
+        }
+
+        constexpr size_t size() const {
+            return is_array_like<L>::value ? detail::length(l) : detail::length(r);
+        }
+
+        constexpr operator std::array<value_type, static_size>() const {
+            std::array<value_type, static_size> result {};
+
+            for (size_t i = 0; i < static_size; i++)
+                result[i] = (*this)[i];
+
+            return result;
+        }
+
+        operator std::vector<value_type>() const {
+            std::vector<value_type> result(size());
+
+            for (size_t i = 0; i < result.size(); i++)
+                result[i] = (*this)[i];
+
+            return result;
+        }
+    };
+
+    namespace detail {
+        template <template < class > class OP, typename A>
+        constexpr std::decay_t<A> fold(A&& a) {
+            return std::forward<A>(a);
+        }
+
+        // Left fold of the arguments, a op b op c is (a op b) op c.
+        template <template < class > class OP, typename A, typename B, typename ... Args>
+        constexpr auto fold(A&& a, B&& b, Args&& ... args) {
+            using value_type = typename array_expression<void, std::decay_t<A>, std::decay_t<B>>::value_type;
+            using expression = array_expression<OP<value_type>, stored_t<A&&>, stored_t<B&&>>;
+
+            return fold<OP>(expression {std::forward<A>(a), std::forward<B>(b)}, std::forward<Args>(args)...);
+        }
+    }
+
+    namespace detail {
+        // Array type an operand evaluates to, the array type of the operands for expressions.
+        template <typename A>
+        struct result_array {
+            using type = std::decay_t<A>;
+        };
+
+        template <typename OP, typename L, typename R>
+        struct result_array<array_expression<OP, L, R>> {
+            using value_type = typename array_expression<OP, L, R>::value_type;
+            static constexpr size_t size = array_expression<OP, L, R>::static_size;
+
+            using type = std::conditional_t<size != 0, std::array<value_type, size>, std::vector<value_type>>;
+        };
+
+        template <typename A>
+        using result_array_t = typename result_array<std::decay_t<A>>::type;
     }
 
-    /** Base function that performs arithmatics with enumerations.
+    /** Unevaluated addition, see array_expression. Use it to nest arithmatics in a single 
+     * loop, the expression references lvalue operands so it should not outlive them.
      * 
      * Template arguments:
-     * @param OP    Type of the arithmatic function pointer (e.g. std::plus, std::minus etc.)
-     * @param A     Type of the results which should be an enumeration.
-     * @param T     Type of the enumeration.
+     * @param A     Type of the first operand which should be an enumeration.
+     * @param Args  Types of the other operands, enumerations or scalars.
      */
-    template<template < class > class OP, typename A, typename T>
-    std::enable_if_t<is_stl_container<T>::value, void> math (A& a, T&& t) {
-        // Define the fundamental type of the enumration (int, double, float etc.).
-        typedef typename std::remove_reference<T &&>::type::value_type value_type;
+    template<typename A, typename ... Args, typename = std::enable_if_t<is_array_like<A>::value>>
+    constexpr auto add_expr (A&& a, Args&& ... args) {
+        return detail::fold<std::plus>(std::forward<A>(a), std::forward<Args>(args)...);
+    }
 
-        for (int i  = 0; i < a.size(); i++) {
-            a[i] = OP<value_type>()(a[i], t[i]);
-        }
+    /** Unevaluated subtraction, see add_expr.
+     * 
+     * Template arguments:
+     * @param A     Type of the first operand which should be an enumeration.
+     * @param Args  Types of the other operands, enumerations or scalars.
+     */
+    template<typename A, typename ... Args, typename = std::enable_if_t<is_array_like<A>::value>>
+    constexpr auto min_expr (A&& a, Args&& ... args) {
+        return detail::fold<std::minus>(std::forward<A>(a), std::forward<Args>(args)...);
     }
 
-    /** Add function that performs addition arithmatics.
+    /** Unevaluated multiplication, see add_expr.
      * 
      * Template arguments:
-     * @param A     Type of the results which should be an enumeration.
-     * @param T     Type of the enumeration.
+     * @param A     Type of the first operand which should be an enumeration.
+     * @param Args  Types of the other operands, enumerations or scalars.
      */
-    template<typename A, typename ... Args>
-    A add (A& a, Args&& ... args) {
-        const auto arguments = {args...};
-        A result = a;
+    template<typename A, typename ... Args, typename = std::enable_if_t<is_array_like<A>::value>>
+    constexpr auto mul_expr (A&& a, Args&& ... args) {
+        return detail::fold<std::multiplies>(std::forward<A>(a), std::forward<Args>(args)...);
+    }
 
-        std::for_each(arguments.begin(), arguments.end(), [&](auto& i){
-            // Perform operation for each argument.
-            math<std::plus>(result, i);
-        });
+    /** Unevaluated division, see add_expr.
+     * 
+     * Template arguments:
+     * @param A     Type of the first operand which should be an enumeration.
+     * @param Args  Types of the other operands, enumerations or scalars.
+     */
+    template<typename A, typename ... Args, typename = std::enable_if_t<is_array_like<A>::value>>
+    constexpr auto div_expr (A&& a, Args&& ... args) {
+        return detail::fold<std::divides>(std::forward<A>(a), std::forward<Args>(args)...);
+    }
 
-        return result;
+    /** Add function that performs addition arithmatics.
+     * The result is an array of the type of the first operand, other operands may be 
+     * expressions (e.g. add(a, min_expr(b, c))) which are evaluated in the same loop.
+     * 
+     * Template arguments:
+     * @param A     Type of the first operand which should be an enumeration.
+     * @param Args  Types of the other operands, enumerations or scalars.
+     */
+    template<typename A, typename ... Args, typename = std::enable_if_t<is_array_like<A>::value>>
+    constexpr detail::result_array_t<A> add (A&& a, Args&& ... args) {
+        return add_expr(std::forward<A>(a), std::forward<Args>(args)...);
     }
 
     /** Min function that performs minus arithmatics.
      * 
      * Template arguments:
-     * @param A     Type of the results which should be an enumeration.
-     * @param T     Type of the enumeration.
+     * @param A     Type of the first operand which should be an enumeration.
+     * @param Args  Types of the other operands, enumerations or scalars.
      */
-    template<typename A, typename ... Args>
-    A min (A& a, Args&& ... args) {
-        const auto arguments = {args...};
-        A result = a;
-
-        std::for_each(arguments.begin(), arguments.end(), [&](auto& i){
-            // Perform operation for each argument.
-            math<std::minus>(result, i);
-        });
-
-        return result;
+    template<typename A, typename ... Args, typename = std::enable_if_t<is_array_like<A>::value>>
+    constexpr detail::result_array_t<A> min (A&& a, Args&& ... args) {
+        return min_expr(std::forward<A>(a), std::forward<Args>(args)...);
     }
 
     /** Mul function that performs multiplication arithmatics.
      * 
      * Template arguments:
-     * @param A     Type of the results which should be an enumeration.
-     * @param T     Type of the enumeration.
+     * @param A     Type of the first operand which should be an enumeration.
+     * @param Args  Types of the other operands, enumerations or scalars.
      */
-    template<typename A, typename ... Args>
-    A mul (A& a, Args&& ... args) {
-        const auto arguments = {args...};
-        A result = a;
-
-        std::for_each(arguments.begin(), arguments.end(), [&](auto& i){
-            // Perform operation for each argument.
-            math<std::multiplies>(result, i);
-        });
-
-        return result;
+    template<typename A, typename ... Args, typename = std::enable_if_t<is_array_like<A>::value>>
+    constexpr detail::result_array_t<A> mul (A&& a, Args&& ... args) {
+        return mul_expr(std::forward<A>(a), std::forward<Args>(args)...);
     }
 
     /** Div function that performs division arithmatics.
      * 
      * Template arguments:
-     * @param A     Type of the results which should be an enumeration.
-     * @param T     Type of the enumeration.
+     * @param A     Type of the first operand which should be an enumeration.
+     * @param Args  Types of the other operands, enumerations or scalars.
      */
-    template<typename A, typename ... Args>
-    A div (A& a, Args&& ... args) {
-        const auto arguments = {args...};
-        A result = a;
-
-        std::for_each(arguments.begin(), arguments.end(), [&](auto& i){
-            // Perform operation for each argument.
-            math<std::divides>(result, i);
-        });
-
-        return result;
+    template<typename A, typename ... Args, typename = std::enable_if_t<is_array_like<A>::value>>
+    constexpr detail::result_array_t<A> div (A&& a, Args&& ... args) {
+        return div_expr(std::forward<A>(a), std::forward<Args>(args)...);
     }
 
     /** Accumulate function that performs accumulation arithmatic on enumeration.
      * 
      * Template arguments:
-     * @param T     Type of the enumeration.
+     * @param A     Type of the enumeration or array expression.
      */
-    template<typename T, size_t N>
-    //typename std::remove_reference<T &&>::type::value_type 
-    inline T accum (std::array<T, N>&& t) {
-        T result = 0;
+    template<typename A, typename = std::enable_if_t<is_array_like<A>::value>>
+    constexpr auto accum (const A& a) {
+        typename detail::operand_traits<A>::value_type result = 0;
 
-        for (const auto& i : t) {
-            result += i;
+        for (size_t i = 0; i < a.size(); i++) {
+            result += a[i];
         }
 
         return result;
     }
 
+    namespace detail {
+        /**
+         * Approximation of a^f for 0 <= f < 1, which scales the exponent bits of a.
+         * The float variant works on the bits of a float, so no double arithmetic is 
+         * required on targets with a single precision FPU.
+         */
+        inline double fpow_fraction(double a, double f) {
+            int32_t x[2];
+            std::memcpy(x, &a, sizeof(a));
+
+            x[1] = (int32_t)(f * (x[1] - 1072632447) + 1072632447);
+            x[0] = 0;
+            std::memcpy(&a, x, sizeof(a));
+
+            return a;
+        }
+
+        inline float fpow_fraction(float a, float f) {
+            int32_t x;
+            std::memcpy(&x, &a, sizeof(a));
+
+            x = (int32_t)(f * static_cast<float>(x - 1064866805) + 1064866805.0f);
+            std::memcpy(&a, &x, sizeof(a));
+
+            return a;
+        }
+    }
+
     template<typename T>
     inline T fpow(T a, T b) {
         // calculate approximation with fraction of the exponent
         int e = (int) b;
-        union {
-            double d;
-            int x[2];
-        } u = { a };
-
-        u.x[1] = (int)((b - e) * (u.x[1] - 1072632447) + 1072632447);
-        u.x[0] = 0;
+        T d {detail::fpow_fraction(a, b - static_cast<T>(e))};
 
         // exponentiation by squaring with the exponent's integer part
-        // double r = u.d makes everything much slower, not sure why
-        double r {1.0};
+        T r {1};
         while (e) {
             if (e & 1) 
                 r *= a;
@@ -175,35 +316,145 @@ namespace ml {
             e >>= 1;
         }
 
-        return r * u.d;
+        return r * d;
+    }
+
+    /** 
+     * Accuracy of the geometric functions below (sqrt, rsqrt, norm, rnorm, unit_vector and angle_ratio).
+     * 
+     * exact:   Uses std::sqrt, results are correctly rounded per operation.
+     * fast:    Uses a bit estimate of the reciprocal square root with two Newton iterations. 
+     *          The relative error of rsqrt, sqrt, norm and rnorm is below 5e-6 for float and double
+     *          (the fpow approximation of the square root is off up to 4%). Types without a bit
+     *          estimate, e.g. long double, use the exact functions.
+     *          A zero vector has a unit vector of zero in both modes.
+     * 
+     * The default is selected with MOTION_MATH_ACCURACY in Config.hpp.
+     */
+    enum class accuracy { exact, fast };
+
+    // Tag of an accuracy, the functions are selected by overloading so only the selected mode is instantiated.
+    template<accuracy A>
+    using accuracy_tag = std::integral_constant<accuracy, A>;
+
+    namespace detail {
+        inline float rsqrt_estimate(float x) {
+            uint32_t i;
+            std::memcpy(&i, &x, sizeof(x));
+            i = 0x5f375a86u - (i >> 1);
+            std::memcpy(&x, &i, sizeof(x));
+            return x;
+        }
+
+        inline double rsqrt_estimate(double x) {
+            uint64_t i;
+            std::memcpy(&i, &x, sizeof(x));
+            i = 0x5fe6eb50c7b537a9ull - (i >> 1);
+            std::memcpy(&x, &i, sizeof(x));
+            return x;
+        }
+
+        template<typename T>
+        inline T newton_rsqrt(T x, T y) {
+            const T half {static_cast<T>(0.5)}, three_half {static_cast<T>(1.5)};
+            y = y * (three_half - half * x * y * y);
+            y = y * (three_half - half * x * y * y);
+            return y;
+        }
+
+        template<typename T>
+        inline T rsqrt(T x, accuracy_tag<accuracy::exact>) {
+            return 1 / std::sqrt(x);
+        }
+
+        // Types without a bit estimate, e.g. long double, use the exact variant.
+        template<typename T>
+        inline T rsqrt(T x, accuracy_tag<accuracy::fast>) {
+            return rsqrt(x, accuracy_tag<accuracy::exact>());
+        }
+
+        inline float rsqrt(float x, accuracy_tag<accuracy::fast>) {
+            return newton_rsqrt(x, rsqrt_estimate(x));
+        }
+
+        inline double rsqrt(double x, accuracy_tag<accuracy::fast>) {
+            return newton_rsqrt(x, rsqrt_estimate(x));
+        }
+
+        template<typename T>
+        inline T sqrt(T x, accuracy_tag<accuracy::exact>) {
+            return std::sqrt(x);
+        }
+
+        template<typename T>
+        inline T sqrt(T x, accuracy_tag<accuracy::fast>) {
+            return x * rsqrt(x, accuracy_tag<accuracy::fast>());
+        }
+
+        template<typename T, size_t N, typename E>
+        inline void normalize(std::array<T, N>& result, const E& vec, T length_2, accuracy_tag<accuracy::exact>) {
+            T length {std::sqrt(length_2)};
+            for (size_t i = 0; i < N; i++)
+                result[i] = vec[i] / length;
+        }
+
+        template<typename T, size_t N, typename E>
+        inline void normalize(std::array<T, N>& result, const E& vec, T length_2, accuracy_tag<accuracy::fast>) {
+            T r {rsqrt(length_2, accuracy_tag<accuracy::fast>())};
+            for (size_t i = 0; i < N; i++)
+                result[i] = vec[i] * r;
+        }
+    }
+
+    template<accuracy A = accuracy::MOTION_MATH_ACCURACY, typename T>
+    inline T rsqrt(T x) {
+        return detail::rsqrt(x, accuracy_tag<A>());
+    }
+
+    template<accuracy A = accuracy::MOTION_MATH_ACCURACY, typename T>
+    inline T sqrt(T x) {
+        return detail::sqrt(x, accuracy_tag<A>());
     }
 
     /* Utiliary functions regarding array arithmatics */
-    template<typename T, size_t N>
-    inline T dot(std::array<T, N>& a, std::array<T, N>& b) {
-        return ml::accum(ml::mul(a, b));
+    template<typename E, typename F, typename = std::enable_if_t<is_array_like<E>::value and is_array_like<F>::value>>
+    constexpr auto dot(const E& a, const F& b) {
+        typename detail::operand_traits<E>::value_type result {0};
+
+        for (size_t i = 0; i < a.size(); i++)
+            result += a[i] * b[i];
+
+        return result;
     }
 
-    template<typename T, size_t N>
-    inline T norm(std::array<T, N>& a) { 
-        return ml::fpow(ml::accum(ml::mul(a, a)), 0.5); 
+    template<accuracy A = accuracy::MOTION_MATH_ACCURACY, typename E>
+    inline auto norm(const E& a) { 
+        return ml::sqrt<A>(dot(a, a)); 
     } 
 
-    template<typename T, size_t N>
-    inline T angle_ratio(std::array<T, N>& a, std::array<T, N>& b, std::array<T, N>& c) {
+    template<accuracy A = accuracy::MOTION_MATH_ACCURACY, typename E>
+    inline auto rnorm(const E& a) { 
+        return ml::rsqrt<A>(dot(a, a)); 
+    } 
+
+    template<accuracy A = accuracy::MOTION_MATH_ACCURACY, typename T, size_t N>
+    inline T angle_ratio(const std::array<T, N>& a, const std::array<T, N>& b, const std::array<T, N>& c) {
         // Calculate the delta's between b-a and b-c
-        std::array<T, N> ab {ml::min(a, b)};
-        std::array<T, N> cb {ml::min(c, b)};
+        std::array<T, N> ab, cb;
+        for (size_t i = 0; i < N; i++) {
+            ab[i] = a[i] - b[i];
+            cb[i] = c[i] - b[i];
+        }
 
-        T ratio = std::fabs(dot(ab, cb) / (norm(ab) * norm(cb)));
-        ratio = ml::fpow(ratio, 3.0) / pi_d; // CORNER_VELOCITY_RATIO
+        T ratio = std::fabs(dot(ab, cb) * ml::rsqrt<A>(dot(ab, ab) * dot(cb, cb)));
+        ratio = (ratio * ratio * ratio) / static_cast<T>(3.14159265359); // CORNER_VELOCITY_RATIO
 
         // Smallest corner ratio allowed.
-        if (ratio < 0.01){ // CORNER_MAX_RATIO
-            ratio = 0.01;  // CORNER_MAX_RATIO
+        if (ratio < static_cast<T>(0.01)){ // CORNER_MAX_RATIO
+            ratio = static_cast<T>(0.01);  // CORNER_MAX_RATIO
         }
         else if (std::isnan(ratio) or std::isinf(ratio)) {
-            ratio = 0.01;  // CORNER_MAX_RATIO
+            ratio = static_cast<T>(0.01);  // CORNER_MAX_RATIO
         }
         
         return ratio;
@@ -219,25 +470,119 @@ namespace ml {
         return ml::mul(a, b);
     }
 
-    template<typename T, size_t N>
-    inline std::array<T, N> unit_vector(std::array<T, N>& vec){
-        return ml::div(vec, norm(vec));
+    template<accuracy A = accuracy::MOTION_MATH_ACCURACY, typename E,
+             typename T = typename detail::operand_traits<E>::value_type, size_t N = detail::operand_traits<E>::size>
+    inline std::array<T, N> unit_vector(const E& vec){
+        std::array<T, N> result {};
+        T length_2 {dot(vec, vec)};
+
+        if (length_2 > 0)
+            detail::normalize(result, vec, length_2, accuracy_tag<A>());
+
+        return result;
     }
 
     template<typename T>
-    T integrate(T v_begin, T v, T v_prev, T dt){
-        return ((v_begin + (v - v_prev) * 0.5) * dt);
+    constexpr T integrate(T v_begin, T v, T v_prev, T dt){
+        return ((v_begin + (v - v_prev) * T(0.5)) * dt);
     }
 
     template<typename T>
     inline T discrete(T t){
-        return static_cast<T>(trunc(fabs(t)));
+        return static_cast<T>(std::trunc(std::fabs(t)));
     }
 
     template<typename T>
-    T sgn(T val) {
+    constexpr T sgn(T val) {
         return (T(0) < val) - (val < T(0));
     }
+
+    /**
+     * Functions of <cmath> which the solvers shared with constant expressions take as a policy, 
+     * see PhaseSolver and constant::math.
+     */
+    struct math {
+        template<typename T>
+        static T sqrt(T x) { return std::sqrt(x); }
+
+        template<typename T>
+        static T ceil(T x) { return std::ceil(x); }
+    };
+
+    /**
+     * Functions of <cmath> and the geometric functions above which can be evaluated at compile time, 
+     * e.g. for StaticMove. The roots are Newton iterations from above, which decrease monotonically 
+     * until the result is within one ulp of the exact root. At runtime use the std variants.
+     */
+    namespace constant {
+        template<typename T>
+        constexpr T sqrt(T x) {
+            if (!(x > 0) || x == std::numeric_limits<T>::infinity())
+                return x == 0 || x == std::numeric_limits<T>::infinity() ? x : std::numeric_limits<T>::quiet_NaN();
+
+            T y {1};
+            while (y * y < x)
+                y *= 2;
+
+            for (T next {(y + x / y) / 2}; next < y; next = (y + x / y) / 2)
+                y = next;
+
+            return y;
+        }
+
+        template<typename T>
+        constexpr T cbrt(T x) {
+            if (x < 0)
+                return -cbrt(-x);
+            if (x == 0 || x == std::numeric_limits<T>::infinity() || x != x)
+                return x;
+
+            T y {1};
+            while (y * y * y < x)
+                y *= 2;
+
+            for (T next {(2 * y + x / (y * y)) / 3}; next < y; next = (2 * y + x / (y * y)) / 3)
+                y = next;
+
+            return y;
+        }
+
+        template<typename T>
+        constexpr T ceil(T x) {
+            T i {static_cast<T>(static_cast<long long>(x))};
+            return i < x ? i + 1 : i;
+        }
+
+        template<typename E>
+        constexpr auto norm(const E& a) { 
+            return constant::sqrt(dot(a, a)); 
+        } 
+
+        template<typename E, typename T = typename detail::operand_traits<E>::value_type, 
+                 size_t N = detail::operand_traits<E>::size>
+        constexpr std::array<T, N> unit_vector(const E& vec){
+            std::array<T, N> result {};
+            T length {constant::norm(vec)};
+
+            if (length > 0) {
+                for (size_t i = 0; i < N; i++)
+                    result[i] = vec[i] / length;
+            }
+
+            return result;
+        }
+
+        /**
+         * The functions above as the policy of ml::math.
+         */
+        struct math {
+            template<typename T>
+            static constexpr T sqrt(T x) { return constant::sqrt(x); }
+
+            template<typename T>
+            static constexpr T ceil(T x) { return constant::ceil(x); }
+        };
+    }
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,46 @@
+/**
+ * Copyright (c) 2020 Bas Brussen
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.                                                                         
+ * 
+ * 
+ * @file Config.hpp
+ *
+ * @brief Config holds the macros which change the behavior of the library at compile time.
+ *
+ * @author Bas Brussen
+ * Contact: b.brussen@outlook.com
+ *
+ */
+
+#ifndef Config_hpp
+#define Config_hpp
+
+// Collect planner and sampler statistics, see Instrumentation.hpp. 
+// Disabled by default, enable with -DMOTION_INSTRUMENTATION=1.
+#ifndef MOTION_INSTRUMENTATION
+#define MOTION_INSTRUMENTATION 0
+#endif
+
+// Accuracy of the geometric functions in ArrayMath.hpp, exact or fast. See ml::accuracy.
+#ifndef MOTION_MATH_ACCURACY
+#define MOTION_MATH_ACCURACY exact
+#endif
+
+#endif
@@ -35,6 +35,7 @@
 
 #include "Polynomial.hpp"
 #include "ArrayMath.hpp"
+#include "Simd.hpp"
 
 
 /**
@@ -45,6 +46,10 @@ struct Point {
     std::array<T, N> setpoint {};
     std::array<T, N> p_prev {};
     T velocity {}, acceleration {};
+
+    // Final velocity as given to plan(), only used by plan_batch() when has_final is set.
+    T v_final {};
+    bool has_final {false};
     
     Point() : 
         velocity(0), 
@@ -64,6 +69,13 @@ struct Point {
         velocity(velocity), 
         acceleration(acceleration) {}
 
+    Point(std::array<T, N> setpoint, T velocity, T acceleration, T v_final) : 
+        setpoint(setpoint), 
+        velocity(velocity), 
+        acceleration(acceleration),
+        v_final(v_final),
+        has_final(true) {}
+
     std::array<T, N> operator- (Point<T, N>& p) {
         return ml::min(this->setpoint, p.setpoint);
     }
@@ -72,11 +84,23 @@ struct Point {
         setpoint = p.setpoint;
         velocity = p.velocity;
         acceleration = p.acceleration;
+        v_final = p.v_final;
+        has_final = p.has_final;
 
         return *this;
     }
 };
 
+/**
+ * Position, velocity and acceleration of all dimensions at one sample.
+ */
+template <typename T, size_t N>
+struct MotionState {
+    std::array<T, N> position {};
+    std::array<T, N> velocity {};
+    std::array<T, N> acceleration {};
+};
+
 /**
  * Complete motion type for a Nth dimensional carthesian motion.
  * The polynomial is inherited and used to calculate velocities on the go.
@@ -92,18 +116,27 @@ struct MotionObject : public Polynomial<T> {
 
     int n {0};
 
-    MotionObject() {}
-    virtual ~MotionObject() {}
+    // Amount of samples by which the motion starts before the end of the previous motion. During 
+    // these samples both motions are superposed, see MotionPlanner::set_blend_tolerance().
+    int blend {0};
 
-    void reset(){
+    // First sample of the motion, counted from the first planned motion.
+    long long start {0};
+
+    constexpr MotionObject() {}
+
+    constexpr void reset(){
         is_coast = false;
         v_target = 0.0;
         dt = 0.0;
         n = 0;
+        blend = 0;
         this->p_0 = 0;
     }
 
     T get_acceleration(int _n, int i) {
+        if (is_coast)
+            return 0;
         return (this->polynomial_a(dt * _n) * unit_vector[i]);
     }
 
@@ -119,12 +152,180 @@ struct MotionObject : public Polynomial<T> {
         return (this->polynomial_p(dt * _n) * unit_vector[i]) + prev_setpoint[i];
     }
 
-    MotionObject<T, N>& operator= (MotionObject<T, N> m) {
+    /**
+     * Block variants of the getters above. The polynomial is evaluated once
+     * and scaled by the unit vector for all dimensions.
+     *
+     * @param _n    Sample of the motion.
+     * @param out   Array which receives the values of all dimensions.
+     */
+    void get_acceleration(int _n, std::array<T, N>& out) {
+        T a {is_coast ? 0 : this->polynomial_a(dt * _n)};
+
+        for (size_t i = 0; i < N; i++)
+            out[i] = a * unit_vector[i];
+    }
+
+    void get_velocity(int _n, std::array<T, N>& out) {
+        T v {is_coast ? v_target : this->polynomial_v(dt * _n)};
+
+        for (size_t i = 0; i < N; i++)
+            out[i] = v * unit_vector[i];
+    }
+
+    void get_position(int _n, std::array<T, N>& out) {
+        T p {is_coast ? this->p_0 + v_target * (dt * _n) : this->polynomial_p(dt * _n)};
+
+        for (size_t i = 0; i < N; i++)
+            out[i] = (p * unit_vector[i]) + prev_setpoint[i];
+    }
+
+    /**
+     * Block variants which evaluate count consecutive samples starting at _n.
+     * The polynomial is evaluated with the vectorized kernels of ml::simd.
+     *
+     * @param _n    First sample of the block.
+     * @param count Amount of samples.
+     * @param out   Buffer of at least count samples.
+     */
+    void get_acceleration(int _n, size_t count, std::array<T, N>* out) {
+        get_block(_n, count, out, [this](int n, size_t c, T* a) {
+            if (is_coast)
+                std::fill(a, a + c, T(0));
+            else
+                ml::simd::polynomial_a<T>(*this, n, dt, c, a);
+        });
+    }
+
+    void get_velocity(int _n, size_t count, std::array<T, N>* out) {
+        get_block(_n, count, out, [this](int n, size_t c, T* v) {
+            if (is_coast)
+                std::fill(v, v + c, v_target);
+            else
+                ml::simd::polynomial_v<T>(*this, n, dt, c, v);
+        });
+    }
+
+    void get_position(int _n, size_t count, std::array<T, N>* out) {
+        get_block(_n, count, out, [this](int n, size_t c, T* p) {
+            if (is_coast) {
+                for (size_t k = 0; k < c; k++)
+                    p[k] = this->p_0 + v_target * (dt * (n + static_cast<int>(k)));
+            }
+            else {
+                ml::simd::polynomial_p<T>(*this, n, dt, c, p);
+            }
+        }, &prev_setpoint);
+    }
+
+    /**
+     * Get position, velocity and acceleration of all dimensions with a single evaluation.
+     * 
+     * @param _n    Sample of the motion.
+     * @param out   State which receives the values of all dimensions.
+     */
+    constexpr void get_state(int _n, MotionState<T, N>& out) const {
+        get_state_at(dt * _n, out);
+    }
+
+    /**
+     * Variant of get_state() at a time which does not have to match a sample.
+     * 
+     * @param t     Time since the start of the motion.
+     * @param out   State which receives the values of all dimensions.
+     */
+    constexpr void get_state_at(T t, MotionState<T, N>& out) const {
+        T p {}, v {}, a {};
+
+        if (is_coast) {
+            p = this->p_0 + v_target * t;
+            v = v_target;
+            a = 0;
+        }
+        else {
+            this->polynomial_pva(t, p, v, a);
+        }
+
+        for (size_t i = 0; i < N; i++) {
+            out.position[i] = (p * unit_vector[i]) + prev_setpoint[i];
+            out.velocity[i] = v * unit_vector[i];
+            out.acceleration[i] = a * unit_vector[i];
+        }
+    }
+
+    /**
+     * Block variant of get_state(), see the block variants of the getters.
+     *
+     * @param _n    First sample of the block.
+     * @param count Amount of samples.
+     * @param out   Buffer of at least count states.
+     */
+    void get_state(int _n, size_t count, MotionState<T, N>* out) {
+        T p[block_size], v[block_size], a[block_size];
+
+        for (size_t k = 0; k < count; k += block_size) {
+            size_t c {std::min(block_size, count - k)};
+            int n {_n + static_cast<int>(k)};
+
+            if (is_coast) {
+                for (size_t j = 0; j < c; j++) {
+                    p[j] = this->p_0 + v_target * (dt * (n + static_cast<int>(j)));
+                    v[j] = v_target;
+                    a[j] = 0;
+                }
+            }
+            else {
+                ml::simd::polynomial_p<T>(*this, n, dt, c, p);
+                ml::simd::polynomial_v<T>(*this, n, dt, c, v);
+                ml::simd::polynomial_a<T>(*this, n, dt, c, a);
+            }
+
+            for (size_t j = 0; j < c; j++) {
+                for (size_t i = 0; i < N; i++) {
+                    out[k + j].position[i] = (p[j] * unit_vector[i]) + prev_setpoint[i];
+                    out[k + j].velocity[i] = v[j] * unit_vector[i];
+                    out[k + j].acceleration[i] = a[j] * unit_vector[i];
+                }
+            }
+        }
+    }
+
+    /**
+     * Stepped variant of get_state(). Consecutive samples are advanced with forward 
+     * differences instead of evaluating the polynomials, see PolynomialStepper.
+     * 
+     * @param _n        Sample of the motion.
+     * @param stepper   Stepper which holds the difference tables of this motion.
+     * @param interval  Amount of samples between exact re-anchors.
+     * @param out       State which receives the values of all dimensions.
+     */
+    void get_state(int _n, PolynomialStepper<T>& stepper, int interval, MotionState<T, N>& out) {
+        if (is_coast) {
+            get_state(_n, out);
+            return;
+        }
+
+        stepper.seek(*this, _n, dt, interval);
+
+        T p {stepper.p.value()};
+        T v {stepper.v.value()};
+        T a {stepper.a.value()};
+
+        for (size_t i = 0; i < N; i++) {
+            out.position[i] = (p * unit_vector[i]) + prev_setpoint[i];
+            out.velocity[i] = v * unit_vector[i];
+            out.acceleration[i] = a * unit_vector[i];
+        }
+    }
+
+    constexpr MotionObject<T, N>& operator= (MotionObject<T, N> m) {
         is_coast = m.is_coast;
         unit_vector = m.unit_vector;
         v_target = m.v_target;
         dt = m.dt;
         n = m.n;
+        blend = m.blend;
+        start = m.start;
         prev_setpoint = m.prev_setpoint;
 
         this->c_3 = m.c_3;
@@ -136,6 +337,208 @@ struct MotionObject : public Polynomial<T> {
 
         return *this;
     }
+
+private:
+    // Amount of samples evaluated per kernel call.
+    static constexpr size_t block_size = 64;
+
+    template <typename F>
+    void get_block(int _n, size_t count, std::array<T, N>* out, F evaluate, 
+                   const std::array<T, N>* offset = nullptr) {
+        T values[block_size];
+
+        for (size_t k = 0; k < count; k += block_size) {
+            size_t c {std::min(block_size, count - k)};
+            evaluate(_n + static_cast<int>(k), c, values);
+
+            if (offset) {
+                for (size_t j = 0; j < c; j++)
+                    for (size_t i = 0; i < N; i++)
+                        out[k + j][i] = (values[j] * unit_vector[i]) + (*offset)[i];
+            }
+            else {
+                for (size_t j = 0; j < c; j++)
+                    for (size_t i = 0; i < N; i++)
+                        out[k + j][i] = values[j] * unit_vector[i];
+            }
+        }
+    }
+};
+
+/**
+ * Queued move, the phases which the planner creates for one segment. The unit vector and start 
+ * point of the segment are stored once, every phase only stores the constants of its polynomial
+ * and its amount of samples. The planners create at most two velocity changes per segment with 
+ * a coasting phase between them, which only stores its start distance and velocity. The sampler 
+ * expands one phase at a time into a MotionObject, or evaluates a phase directly with get_state_at().
+ * 
+ * The queues store records of a fixed size, so a move of a single velocity change takes as much 
+ * room as a move of three phases (200 instead of 136 bytes for double and N = 3), while a move of
+ * three phases takes 200 instead of 3 * 136 bytes. A plan call queues one record.
+ * 
+ * Template arguments:
+ * @param T     Type of the scalar.
+ * @param N     Number of dimensions.
+ */
+template <typename T, size_t N>
+struct MoveRecord {
+    static constexpr int max_phases = 3;
+    static constexpr int max_changes = 2;
+
+    std::array<T, N> unit_vector {};
+    std::array<T, N> prev_setpoint {};
+    // Polynomials of the velocity changes, in the order of their phases.
+    std::array<Polynomial<T>, max_changes> change {};
+    // Start distance and velocity of the coasting phase.
+    T coast_p_0 {0.0};
+    T coast_v {0.0};
+    std::array<int, max_phases> n {};
+    T dt {0.0};
+
+    // First sample of the first phase, see MotionObject::start.
+    long long start {0};
+
+    // Overlap of the first phase with the previous move, see MotionObject::blend.
+    int blend {0};
+
+    unsigned char phases {0};
+
+    // Bit i is set when phase i coasts, at most one phase coasts.
+    unsigned char coast {0};
+
+    /**
+     * Add a motion as the next phase of the move.
+     * 
+     * @return False when the move is full or the motion belongs to another segment.
+     */
+    bool append(const MotionObject<T, N>& m) {
+        if (phases == 0) {
+            unit_vector = m.unit_vector;
+            prev_setpoint = m.prev_setpoint;
+            dt = m.dt;
+            start = m.start;
+            blend = m.blend;
+        }
+        else if (phases == max_phases || m.blend != 0 || m.dt != dt 
+                 || m.unit_vector != unit_vector || m.prev_setpoint != prev_setpoint) {
+            return false;
+        }
+
+        if (m.is_coast) {
+            if (coast != 0)
+                return false;
+
+            coast_p_0 = m.p_0;
+            coast_v = m.v_target;
+            coast |= 1 << phases;
+        }
+        else {
+            int i {changes()};
+            if (i == max_changes)
+                return false;
+
+            change[i] = m;
+        }
+
+        n[phases] = m.n;
+        phases++;
+        return true;
+    }
+
+    /**
+     * Expand phase i into a motion. Only a coasting phase has a target velocity.
+     */
+    constexpr void get_motion(int i, MotionObject<T, N>& m) const {
+        if (is_coast(i)) {
+            static_cast<Polynomial<T>&>(m) = Polynomial<T>();
+            m.v_0 = coast_v;
+            m.p_0 = coast_p_0;
+        }
+        else {
+            static_cast<Polynomial<T>&>(m) = change[change_index(i)];
+        }
+
+        m.unit_vector = unit_vector;
+        m.prev_setpoint = prev_setpoint;
+        m.is_coast = is_coast(i);
+        m.v_target = is_coast(i) ? coast_v : 0;
+        m.dt = dt;
+        m.n = n[i];
+        m.blend = i == 0 ? blend : 0;
+        m.start = phase_start(i);
+    }
+
+    constexpr bool is_coast(int i) const {
+        return (coast >> i) & 1;
+    }
+
+    /**
+     * Amount of velocity changes of the move.
+     */
+    constexpr int changes() const {
+        return phases - (coast != 0 ? 1 : 0);
+    }
+
+    /**
+     * Velocity change of phase i, which does not coast.
+     */
+    constexpr int change_index(int i) const {
+        return i - ((coast & ((1 << i) - 1)) != 0 ? 1 : 0);
+    }
+
+    /**
+     * First sample of phase i. A phase without samples still takes one sample.
+     */
+    constexpr long long phase_start(int i) const {
+        long long k {start};
+        for (int j = 0; j < i; j++)
+            k += std::max(n[j], 1);
+        return k;
+    }
+
+    /**
+     * Sample after the last phase.
+     */
+    constexpr long long end() const {
+        return phase_start(phases - 1) + std::max(n[phases - 1], 1);
+    }
+
+    /**
+     * Last phase which starts at or before sample k, the first phase when k is before the move.
+     */
+    constexpr int phase_at(long long k) const {
+        int i {0};
+        long long s {start};
+
+        while (i + 1 < phases && k >= s + std::max(n[i], 1)) {
+            s += std::max(n[i], 1);
+            i++;
+        }
+
+        return i;
+    }
+
+    /**
+     * State of phase i at time t, equal to MotionObject::get_state_at() of the expanded phase.
+     */
+    constexpr void get_state_at(int i, T t, MotionState<T, N>& out) const {
+        T p {}, v {}, a {};
+
+        if (is_coast(i)) {
+            p = coast_p_0 + coast_v * t;
+            v = coast_v;
+            a = 0;
+        }
+        else {
+            change[change_index(i)].polynomial_pva(t, p, v, a);
+        }
+
+        for (size_t j = 0; j < N; j++) {
+            out.position[j] = (p * unit_vector[j]) + prev_setpoint[j];
+            out.velocity[j] = v * unit_vector[j];
+            out.acceleration[j] = a * unit_vector[j];
+        }
+    }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,273 @@
+/**
+ * Copyright (c) 2020 Bas Brussen
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.                                                                         
+ * 
+ * 
+ * @file FixedMotion.hpp
+ *
+ * @brief Motion which is planned in floating point and sampled in another scalar, e.g. fixed point.
+ *
+ * @author Bas Brussen
+ * Contact: b.brussen@outlook.com
+ *
+ */
+
+#ifndef FixedMotion_hpp
+#define FixedMotion_hpp
+
+#include "MotionPlanner.hpp"
+#include "FixedPoint.hpp"
+
+/**
+ * Motion object converted to the scalar S. The polynomials are evaluated in normalized time 
+ * s = sample / n instead of seconds, which keeps all coefficients in the order of the velocity 
+ * and the length of the motion. The coefficients in seconds grow with 1 / t^6 and do not fit 
+ * the range of a fixed point number.
+ * 
+ * Template arguments:
+ * @param S     Type of the scalar of the samples.
+ * @param N     Number of dimensions.
+ */
+template <typename S, size_t N>
+struct FixedMotionObject {
+    // Coefficients of s^0 ... s^D divided by the scale of the polynomial.
+    std::array<S, 8> p {};
+    std::array<S, 7> v {};
+    std::array<S, 6> a {};
+    S p_scale {1};
+    S v_scale {1};
+    // Includes 1 / duration, the coefficients of the acceleration are multiplied with the duration.
+    S a_scale {};
+
+    std::array<S, N> unit_vector {};
+    std::array<S, N> prev_setpoint {};
+
+    int n {0};
+
+    FixedMotionObject() {}
+
+    /**
+     * Convert a motion. The coefficients are calculated in T and rounded once to S.
+     * 
+     * @param m     Motion to convert.
+     */
+    template <typename T>
+    void assign(const MotionObject<T, N>& m) {
+        // A motion without samples is evaluated at its first sample after it, as BasicMotion does.
+        T d {m.dt * std::max(m.n, 1)};
+        std::array<T, 8> p_t {};
+        std::array<T, 7> v_t {};
+        std::array<T, 6> a_t {};
+
+        p_t[0] = m.p_0;
+
+        if (m.is_coast) {
+            p_t[1] = m.v_target * d;
+            v_t[0] = m.v_target;
+        }
+        else {
+            const T c[4] {m.c_3, m.c_4, m.c_5, m.c_6};
+            T d_k {d * d * d};
+
+            p_t[1] = m.v_0 * d;
+            v_t[0] = m.v_0;
+
+            for (int k = 0; k < 4; k++) {
+                v_t[k + 3] = c[k] * d_k;
+                a_t[k + 2] = (k + 3) * c[k] * d_k;
+                p_t[k + 4] = c[k] * d_k * d / (k + 4);
+                d_k *= d;
+            }
+        }
+
+        p_scale = static_cast<S>(convert_polynomial(p_t, p));
+        v_scale = static_cast<S>(convert_polynomial(v_t, v));
+        a_scale = d > 0 ? static_cast<S>(convert_polynomial(a_t, a) / d) : S(0);
+
+        convert(m.unit_vector, unit_vector);
+        convert(m.prev_setpoint, prev_setpoint);
+
+        n = m.n;
+    }
+
+    /**
+     * Get position, velocity and acceleration of all dimensions, see MotionObject::get_state().
+     * 
+     * @param _n    Sample of the motion.
+     * @param out   State which receives the values of all dimensions.
+     */
+    void get_state(int _n, MotionState<S, N>& out) const {
+        S s {normalized_time(_n, std::max(n, 1), static_cast<S*>(nullptr))};
+
+        S p_s {horner(p, s) * p_scale};
+        S v_s {horner(v, s) * v_scale};
+        S a_s {horner(a, s) * a_scale};
+
+        for (size_t i = 0; i < N; i++) {
+            out.position[i] = (p_s * unit_vector[i]) + prev_setpoint[i];
+            out.velocity[i] = v_s * unit_vector[i];
+            out.acceleration[i] = a_s * unit_vector[i];
+        }
+    }
+
+private:
+    template <typename T, size_t D>
+    static void convert(const std::array<T, D>& from, std::array<S, D>& to) {
+        for (size_t i = 0; i < D; i++)
+            to[i] = static_cast<S>(from[i]);
+    }
+
+    /**
+     * Convert the coefficients of a polynomial. When the sum of their magnitudes exceeds a quarter 
+     * of the range of S, they are divided by a scale such that the partial sums of the evaluation 
+     * stay in range for s <= 1 and the held sample just after it.
+     * 
+     * @return Scale which the evaluated polynomial is multiplied with.
+     */
+    template <typename T, size_t D>
+    static T convert_polynomial(const std::array<T, D>& from, std::array<S, D>& to) {
+        T sum {0};
+        for (T c : from)
+            sum += std::fabs(c);
+
+        T bound {static_cast<T>(std::numeric_limits<S>::max()) / 4};
+        T scale {sum > bound ? sum / bound : T(1)};
+
+        for (size_t i = 0; i < D; i++)
+            to[i] = static_cast<S>(from[i] / scale);
+
+        return scale;
+    }
+
+    template <size_t D>
+    static S horner(const std::array<S, D>& c, S s) {
+        S r {c[D - 1]};
+
+        for (size_t i = D - 1; i > 0; i--)
+            r = r * s + c[i - 1];
+
+        return r;
+    }
+
+    // Sample counts may exceed the integer range of a fixed point number, the ratio is rounded once.
+    template <typename U>
+    static U normalized_time(int k, int n, U*) {
+        return static_cast<U>(k) / static_cast<U>(n);
+    }
+
+    template <int F, typename I, typename W>
+    static ml::Fixed<F, I, W> normalized_time(int k, int n, ml::Fixed<F, I, W>*) {
+        return ml::Fixed<F, I, W>::ratio(k, n);
+    }
+};
+
+/**
+ * Motion which is planned in T and sampled in S. Planning stays in floating point, where the 
+ * square roots and the range of the planner are available, the sampling path only uses 
+ * additions and multiplications of S. With S = ml::q15_16 the sampler runs on integer cores.
+ * The samples follow BasicMotion, including the hold of the final state. Blended corners are 
+ * not superposed, the motions of a corner are sampled one after the other and stop at the corner.
+ * 
+ * Template arguments:
+ * @param T     Type of the scalar of the planner.
+ * @param N     Number of dimensions.
+ * @param S     Type of the scalar of the samples.
+ * @param Q     Queue which stores the moves.
+ * @param B     Buffer policy, see MotionPlanner.
+ * @param P     Profile policy, see MotionPlanner.
+ */
+template <typename T, size_t N, typename S = ml::q15_16, typename Q = std::queue<MoveRecord<T, N>>, 
+          typename B = SetpointBuffer<T, N>, typename P = SmoothProfile<T>>
+class FixedMotion : public MotionPlanner<T, N, Q, B, P> {
+public:
+    bool motion_in_progress {false};
+
+    FixedMotion(int hz) : 
+        MotionPlanner<T, N, Q, B, P>(hz) {}
+
+    FixedMotion(int hz, std::array<T, N> p) : 
+        MotionPlanner<T, N, Q, B, P>(hz, p) {
+        for (size_t i = 0; i < N; i++)
+            current_motion.prev_setpoint[i] = static_cast<S>(p[i]);
+    }
+
+    /**
+     * Plan a motion, see BasicMotion::plan().
+     */
+    inline bool plan(std::array<T, N> pos) {
+        Point<T, N> p(pos);
+        return this->append_and_plan(p);
+    }
+
+    inline bool plan(std::array<T, N> pos, T vel, T acc) {
+        Point<T, N> p(pos, vel, acc);
+        return this->append_and_plan(p);
+    }
+
+    inline bool plan(std::array<T, N> pos, T vel, T acc, T v_final) {
+        Point<T, N> p(pos, vel, acc);
+        return this->append_and_plan(p, v_final);
+    }
+
+    /**
+     * See BasicMotion::increment_motion_sample().
+     */
+    inline bool increment_motion_sample() {
+        MOTION_STATISTICS(this->statistics.record_samples(1));
+        motion_pos++;
+        return motion_in_progress;
+    }
+
+    /**
+     * Get the position, velocity and acceleration of all dimensions, see BasicMotion::get_state_setpoint().
+     * 
+     * @return MotionState<S, N> of position, velocity and acceleration.
+     */
+    inline MotionState<S, N> get_state_setpoint() {
+        MotionState<S, N> state;
+
+        next_motion();
+        current_motion.get_state(motion_pos, state);
+
+        return state;
+    }
+
+private:
+    /**
+     * See BasicMotion::next_motion(), the motion is converted once when it becomes current.
+     */
+    inline void next_motion() {
+        if ((this->motion_queue_size() > 0) && (motion_pos >= current_motion.n)) {
+            motion_in_progress = true;
+            current_motion.assign(this->get_motion());
+            MOTION_STATISTICS(this->statistics.record_switch());
+            motion_pos = 0;
+        }
+        else if ((this->motion_queue_size() == 0) && (motion_pos >= current_motion.n)) {
+            motion_in_progress = false;
+            motion_pos = current_motion.n + 1;
+        }
+    }
+
+    FixedMotionObject<S, N> current_motion;
+    int motion_pos = 0;
+};
+
+#endif
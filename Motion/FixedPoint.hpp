@@ -0,0 +1,146 @@
+/**
+ * Copyright (c) 2020 Bas Brussen
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.                                                                         
+ * 
+ * 
+ * @file FixedPoint.hpp
+ *
+ * @brief Q-format fixed point scalar for targets without a (fast) floating point unit.
+ *
+ * @author Bas Brussen
+ * Contact: b.brussen@outlook.com
+ *
+ */
+
+#ifndef FixedPoint_hpp
+#define FixedPoint_hpp
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace ml {
+    /**
+     * Signed fixed point number with F fractional bits, stored in I. Products and quotients 
+     * are calculated in W and rounded to the nearest value. There is no saturation, results 
+     * must stay within the range of I, e.g. [-32768, 32768) for Q15.16.
+     * 
+     * Template arguments:
+     * @param F     Amount of fractional bits.
+     * @param I     Storage type.
+     * @param W     Type of the intermediate results, at least twice as wide as I.
+     */
+    template <int F, typename I = int32_t, typename W = int64_t>
+    struct Fixed {
+        static_assert(std::is_signed<I>::value && std::is_signed<W>::value, "Fixed requires signed types");
+        static_assert(sizeof(W) >= 2 * sizeof(I), "W must be at least twice as wide as I");
+        static_assert(F > 0 && F < static_cast<int>(8 * sizeof(I)) - 1, "F must leave room for the sign bit");
+
+        static constexpr W one = W(1) << F;
+
+        I raw {0};
+
+        constexpr Fixed() {}
+
+        constexpr Fixed(int v) : 
+            raw(static_cast<I>(static_cast<W>(v) * one)) {}
+
+        template <typename A, typename = std::enable_if_t<std::is_floating_point<A>::value>>
+        constexpr Fixed(A v) : 
+            raw(static_cast<I>(v * static_cast<A>(one) + (v < 0 ? A(-0.5) : A(0.5)))) {}
+
+        static constexpr Fixed from_raw(I r) {
+            Fixed f;
+            f.raw = r;
+            return f;
+        }
+
+        /**
+         * Rounded quotient of two integers, without the range limit of I on num and den.
+         * 
+         * @param num   Numerator.
+         * @param den   Denominator, positive.
+         */
+        static constexpr Fixed ratio(W num, W den) {
+            return from_raw(static_cast<I>((num * one + (num < 0 ? -den / 2 : den / 2)) / den));
+        }
+
+        template <typename A, typename = std::enable_if_t<std::is_arithmetic<A>::value>>
+        explicit constexpr operator A() const {
+            return static_cast<A>(static_cast<A>(raw) / static_cast<A>(one));
+        }
+
+        constexpr Fixed operator- () const { return from_raw(static_cast<I>(-raw)); }
+
+        constexpr Fixed& operator+= (Fixed b) { raw = static_cast<I>(raw + b.raw); return *this; }
+        constexpr Fixed& operator-= (Fixed b) { raw = static_cast<I>(raw - b.raw); return *this; }
+
+        constexpr Fixed& operator*= (Fixed b) {
+            W p {static_cast<W>(raw) * b.raw};
+            raw = static_cast<I>((p + (one >> 1)) >> F);
+            return *this;
+        }
+
+        constexpr Fixed& operator/= (Fixed b) {
+            W q {static_cast<W>(raw) * one};
+            W half {(b.raw < 0 ? -b.raw : b.raw) / 2};
+            raw = static_cast<I>((q + (q < 0 ? -half : half)) / b.raw);
+            return *this;
+        }
+
+        friend constexpr Fixed operator+ (Fixed a, Fixed b) { return a += b; }
+        friend constexpr Fixed operator- (Fixed a, Fixed b) { return a -= b; }
+        friend constexpr Fixed operator* (Fixed a, Fixed b) { return a *= b; }
+        friend constexpr Fixed operator/ (Fixed a, Fixed b) { return a /= b; }
+
+        friend constexpr bool operator== (Fixed a, Fixed b) { return a.raw == b.raw; }
+        friend constexpr bool operator!= (Fixed a, Fixed b) { return a.raw != b.raw; }
+        friend constexpr bool operator< (Fixed a, Fixed b) { return a.raw < b.raw; }
+        friend constexpr bool operator> (Fixed a, Fixed b) { return a.raw > b.raw; }
+        friend constexpr bool operator<= (Fixed a, Fixed b) { return a.raw <= b.raw; }
+        friend constexpr bool operator>= (Fixed a, Fixed b) { return a.raw >= b.raw; }
+
+        friend constexpr Fixed fabs(Fixed a) { return a.raw < 0 ? -a : a; }
+    };
+
+    // Q15.16, range [-32768, 32768) with a resolution of 1.5e-5.
+    using q15_16 = Fixed<16>;
+
+    // Q7.24, range [-128, 128) with a resolution of 6e-8.
+    using q7_24 = Fixed<24>;
+}
+
+namespace std {
+    template <int F, typename I, typename W>
+    class numeric_limits<ml::Fixed<F, I, W>> {
+    public:
+        static constexpr bool is_specialized = true;
+        static constexpr bool is_signed = true;
+        static constexpr bool is_integer = false;
+        static constexpr bool is_exact = true;
+
+        static constexpr ml::Fixed<F, I, W> min() { return ml::Fixed<F, I, W>::from_raw(1); }
+        static constexpr ml::Fixed<F, I, W> max() { return ml::Fixed<F, I, W>::from_raw(numeric_limits<I>::max()); }
+        static constexpr ml::Fixed<F, I, W> lowest() { return ml::Fixed<F, I, W>::from_raw(numeric_limits<I>::min()); }
+        static constexpr ml::Fixed<F, I, W> epsilon() { return ml::Fixed<F, I, W>::from_raw(1); }
+    };
+}
+
+#endif
@@ -0,0 +1,237 @@
+/**
+ * Copyright (c) 2020 Bas Brussen
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.                                                                         
+ * 
+ * 
+ * @file Instrumentation.hpp
+ *
+ * @brief Instrumentation holds the statistics which are collected when MOTION_INSTRUMENTATION is enabled.
+ *
+ * @author Bas Brussen
+ * Contact: b.brussen@outlook.com
+ *
+ */
+
+#ifndef Instrumentation_hpp
+#define Instrumentation_hpp
+
+#include "Config.hpp"
+
+#if MOTION_INSTRUMENTATION
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+// Statements only compiled with instrumentation, so disabled instrumentation costs nothing.
+#define MOTION_STATISTICS(statement) statement
+
+/**
+ * Histogram with power of two bins, written by a single thread. Bin i counts the values in 
+ * [2^(i - offset), 2^(i + 1 - offset)), values outside the range are counted in the first or last bin.
+ */
+template <int Offset>
+struct Histogram {
+    static constexpr size_t bins = 32;
+    std::array<std::atomic<uint64_t>, bins> count {};
+
+    void add(double value) {
+        int bin {value > 0 ? std::ilogb(value) + Offset : 0};
+        bin = bin < 0 ? 0 : (bin >= static_cast<int>(bins) ? static_cast<int>(bins) - 1 : bin);
+        count[bin].store(count[bin].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    void snapshot(std::array<uint64_t, bins>& out) const {
+        for (size_t i = 0; i < bins; i++)
+            out[i] = count[i].load(std::memory_order_relaxed);
+    }
+
+    void reset() {
+        for (auto& c : count)
+            c.store(0, std::memory_order_relaxed);
+    }
+};
+
+/**
+ * Minimum and maximum of a value, updated without locking.
+ */
+struct Extremes {
+    std::atomic<double> min {std::numeric_limits<double>::infinity()};
+    std::atomic<double> max {-std::numeric_limits<double>::infinity()};
+
+    void add(double value) {
+        double m {min.load(std::memory_order_relaxed)};
+        while (value < m && !min.compare_exchange_weak(m, value, std::memory_order_relaxed));
+
+        m = max.load(std::memory_order_relaxed);
+        while (value > m && !max.compare_exchange_weak(m, value, std::memory_order_relaxed));
+    }
+
+    void reset() {
+        min.store(std::numeric_limits<double>::infinity(), std::memory_order_relaxed);
+        max.store(-std::numeric_limits<double>::infinity(), std::memory_order_relaxed);
+    }
+};
+
+/**
+ * Statistics of the planner and sampler. The planner and sampler update the statistics with
+ * relaxed atomics, so snapshot() can be called from any thread without locking. The values of
+ * a snapshot are each exact, but updates which happen during the snapshot may be partially included.
+ * Every counter is written by either the planning or the sampling thread, so counters are 
+ * incremented with a plain load and store instead of a locked read-modify-write.
+ */
+class MotionStatistics {
+public:
+    struct Snapshot {
+        uint64_t plans;                 // Calls of plan().
+        uint64_t transitions;           // Segments planned with transition().
+        uint64_t motions;               // Segments planned with motion().
+        uint64_t look_ahead_segments;   // Segments planned with look-ahead.
+        uint64_t samples;               // Samples taken by the sampler.
+        uint64_t motion_switches;       // Motions taken from the queue by the sampler.
+
+        double error_min, error_max;                    // Carried position error.
+        double plan_ns_min, plan_ns_max;                // Duration of a plan() call.
+        double segment_length_min, segment_length_max;  // Length of planned segments.
+
+        int queue_size, queue_size_max;                 // Queued motions after a plan() call.
+        int motion_length, motion_length_max;           // Queued samples after a plan() call.
+
+        std::array<uint64_t, 32> plan_ns_histogram;         // Bin i counts durations in [2^i, 2^(i + 1)) ns.
+        std::array<uint64_t, 32> segment_length_histogram;  // Bin i counts lengths in [2^(i - 16), 2^(i - 15)).
+    };
+
+    using clock = std::chrono::steady_clock;
+
+    void record_plan(clock::time_point start, int size, int length) {
+        std::chrono::duration<double, std::nano> elapsed {clock::now() - start};
+
+        increment(plans, 1);
+        plan_ns.add(elapsed.count());
+        plan_ns_histogram.add(elapsed.count());
+
+        queue_size.store(size, std::memory_order_relaxed);
+        motion_length.store(length, std::memory_order_relaxed);
+
+        if (size > queue_size_max.load(std::memory_order_relaxed))
+            queue_size_max.store(size, std::memory_order_relaxed);
+
+        if (length > motion_length_max.load(std::memory_order_relaxed))
+            motion_length_max.store(length, std::memory_order_relaxed);
+    }
+
+    void record_transition(double length) {
+        increment(transitions, 1);
+        record_segment(length);
+    }
+
+    void record_motion(double length) {
+        increment(motions, 1);
+        record_segment(length);
+    }
+
+    void record_look_ahead(double length) {
+        increment(look_ahead_segments, 1);
+        record_segment(length);
+    }
+
+    void record_error(double error) {
+        errors.add(error);
+    }
+
+    void record_samples(uint64_t count) {
+        increment(samples, count);
+    }
+
+    void record_switch() {
+        increment(motion_switches, 1);
+    }
+
+    Snapshot snapshot() const {
+        Snapshot s;
+
+        s.plans = plans.load(std::memory_order_relaxed);
+        s.transitions = transitions.load(std::memory_order_relaxed);
+        s.motions = motions.load(std::memory_order_relaxed);
+        s.look_ahead_segments = look_ahead_segments.load(std::memory_order_relaxed);
+        s.samples = samples.load(std::memory_order_relaxed);
+        s.motion_switches = motion_switches.load(std::memory_order_relaxed);
+
+        s.error_min = errors.min.load(std::memory_order_relaxed);
+        s.error_max = errors.max.load(std::memory_order_relaxed);
+        s.plan_ns_min = plan_ns.min.load(std::memory_order_relaxed);
+        s.plan_ns_max = plan_ns.max.load(std::memory_order_relaxed);
+        s.segment_length_min = segment_length.min.load(std::memory_order_relaxed);
+        s.segment_length_max = segment_length.max.load(std::memory_order_relaxed);
+
+        s.queue_size = queue_size.load(std::memory_order_relaxed);
+        s.queue_size_max = queue_size_max.load(std::memory_order_relaxed);
+        s.motion_length = motion_length.load(std::memory_order_relaxed);
+        s.motion_length_max = motion_length_max.load(std::memory_order_relaxed);
+
+        plan_ns_histogram.snapshot(s.plan_ns_histogram);
+        segment_length_histogram.snapshot(s.segment_length_histogram);
+
+        return s;
+    }
+
+    /**
+     * Reset all statistics, should not be called while planning or sampling.
+     */
+    void reset() {
+        for (auto* c : {&plans, &transitions, &motions, &look_ahead_segments, &samples, &motion_switches})
+            c->store(0, std::memory_order_relaxed);
+
+        for (auto* i : {&queue_size, &queue_size_max, &motion_length, &motion_length_max})
+            i->store(0, std::memory_order_relaxed);
+
+        errors.reset();
+        plan_ns.reset();
+        segment_length.reset();
+        plan_ns_histogram.reset();
+        segment_length_histogram.reset();
+    }
+
+private:
+    static void increment(std::atomic<uint64_t>& counter, uint64_t count) {
+        counter.store(counter.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+    }
+
+    void record_segment(double length) {
+        segment_length.add(length);
+        segment_length_histogram.add(length);
+    }
+
+    std::atomic<uint64_t> plans {0}, transitions {0}, motions {0}, look_ahead_segments {0};
+    std::atomic<uint64_t> samples {0}, motion_switches {0};
+    std::atomic<int> queue_size {0}, queue_size_max {0}, motion_length {0}, motion_length_max {0};
+
+    Extremes errors, plan_ns, segment_length;
+    Histogram<0> plan_ns_histogram;
+    Histogram<16> segment_length_histogram;
+};
+
+#else
+#define MOTION_STATISTICS(statement)
+#endif
+
+#endif
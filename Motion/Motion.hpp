@@ -32,33 +32,47 @@
 #define Motion_hpp
 
 #include "MotionPlanner.hpp"
+#include "SampleRange.hpp"
 
-template <typename T, size_t N>
-class Motion : public MotionPlanner<T, N> {
+/**
+ * Motion without virtual functions, all calls on the sampling path can be inlined.
+ * Motion below adds the virtual interface on top of it.
+ * 
+ * Template arguments:
+ * @param T     Type of the scalar.
+ * @param N     Number of dimensions.
+ * @param Q     Queue which stores the moves. With SpscQueue<MoveRecord<T, N>, Capacity> plan() 
+ *              may run on another thread than the sampling functions. With SpscQueue or 
+ *              FixedQueue no allocations are made after construction.
+ * @param B     Buffer policy which holds the last planned points, see SetpointBuffer.
+ * @param P     Profile policy which shapes the velocity changes, see SmoothProfile.
+ */
+template <typename T, size_t N, typename Q = std::queue<MoveRecord<T, N>>, 
+          typename B = SetpointBuffer<T, N>, typename P = SmoothProfile<T>>
+class BasicMotion : public MotionPlanner<T, N, Q, B, P> {
 public:
     bool motion_in_progress;
 
-    Motion() : MotionPlanner<T, N>(0) {}
+    BasicMotion() : MotionPlanner<T, N, Q, B, P>(0) {}
 
-    Motion(int hz) : 
-        MotionPlanner<T, N>(hz),
+    BasicMotion(int hz) : 
+        MotionPlanner<T, N, Q, B, P>(hz),
         motion_in_progress(false) {}
 
-    Motion(int hz, std::array<T, N> p) : 
-        MotionPlanner<T, N>(hz, p),
-        p_init(p),
-        motion_in_progress(false) { } 
-
-    virtual ~Motion() {}
+    BasicMotion(int hz, std::array<T, N> p) : 
+        MotionPlanner<T, N, Q, B, P>(hz, p),
+        motion_in_progress(false),
+        p_init(p) { } 
 
     /**
      * Plan a motion.
      * 
      * @param pos   Position setpoint.
+     * @return False when a FixedQueue is full, the point is not planned. See motion_queue_space().
      */
-    inline void plan(std::array<T, N> pos) {
+    inline bool plan(std::array<T, N> pos) {
         Point<T, N> p(pos);
-        this->append_and_plan(p);
+        return this->append_and_plan(p);
     }
 
     /**
@@ -67,10 +81,11 @@ public:
      * @param pos   Position setpoint.
      * @param vel   Velocity constraint.
      * @param acc   Acceleration constraint.
+     * @return False when a FixedQueue is full, the point is not planned.
      */
-    inline void plan(std::array<T, N> pos, T vel, T acc) {
+    inline bool plan(std::array<T, N> pos, T vel, T acc) {
         Point<T, N> p(pos, vel, acc);
-        this->append_and_plan(p);
+        return this->append_and_plan(p);
     }
 
     /**
@@ -80,10 +95,11 @@ public:
      * @param vel       Velocity constraint.
      * @param acc       Acceleration constraint.
      * @param v_final   Final velocity.
+     * @return False when a FixedQueue is full, the point is not planned.
      */
-    inline void plan(std::array<T, N> pos, T vel, T acc, T v_final) {
+    inline bool plan(std::array<T, N> pos, T vel, T acc, T v_final) {
         Point<T, N> p(pos, vel, acc);
-        this->append_and_plan(p, v_final);
+        return this->append_and_plan(p, v_final);
     }
 
     /**
@@ -94,7 +110,8 @@ public:
      * 
      * @return A boolean to indicate if a motion is still in progress or not.
      */
-    virtual inline bool increment_motion_sample() {
+    inline bool increment_motion_sample() {
+        MOTION_STATISTICS(this->statistics.record_samples(1));
         motion_pos++;
         return motion_in_progress;
     }
@@ -104,22 +121,14 @@ public:
      * 
      * @return std::array<T, N> of accelerations.
      */
-    virtual std::array<T, N> get_acceleration_setpoint() {
+    inline std::array<T, N> get_acceleration_setpoint() {
         std::array<T, N> acceleration;
 
-        if ((this->motion_queue_size() > 0) && (motion_pos >= current_motion.n)) {
-            motion_in_progress = true;
-            current_motion = this->get_motion();
-            motion_pos = 0;
-        }  
+        next_motion();
+        current_motion.get_acceleration(motion_pos, acceleration);
 
-        else if ((this->motion_queue_size() == 0) && (motion_pos >= current_motion.n)){
-            motion_in_progress = false;
-            motion_pos = current_motion.n + 1;
-        }
-
-        for (size_t i = 0; i < N; i++)
-            acceleration[i] = current_motion.get_acceleration(motion_pos, i);
+        if (blend_motion())
+            acceleration = ml::add_expr(acceleration, blend_state().acceleration);
 
         return acceleration;
     }
@@ -129,22 +138,14 @@ public:
      * 
      * @return std::array<T, N> of velocity.
      */
-    inline virtual std::array<T, N> get_velocity_setpoint() {
+    inline std::array<T, N> get_velocity_setpoint() {
         std::array<T, N> velocities;
 
-        if ((this->motion_queue_size() > 0) && (motion_pos >= current_motion.n)) {
-            motion_in_progress = true;
-            current_motion = this->get_motion();
-            motion_pos = 0;
-        }  
-
-        else if ((this->motion_queue_size() == 0) && (motion_pos >= current_motion.n)){
-            motion_in_progress = false;
-            motion_pos = current_motion.n + 1;
-        }
+        next_motion();
+        current_motion.get_velocity(motion_pos, velocities);
 
-        for (size_t i = 0; i < N; i++)
-            velocities[i] = current_motion.get_velocity(motion_pos, i);
+        if (blend_motion())
+            velocities = ml::add_expr(velocities, blend_state().velocity);
 
         return velocities;
     }
@@ -154,42 +155,473 @@ public:
      * 
      * @return std::array<T, N> of position.
      */
-    virtual std::array<T, N> get_position_setpoint() {
+    inline std::array<T, N> get_position_setpoint() {
         std::array<T, N> positions;
 
+        next_motion();
+        current_motion.get_position(motion_pos, positions);
+
+        if (blend_motion())
+            positions = ml::add_expr(positions, blend_state().position);
+
+        return positions;
+    }
+
+    /**
+     * Get the position, velocity and acceleration of all dimensions.
+     * The motion is advanced and evaluated once for all three.
+     * 
+     * @return MotionState<T, N> of position, velocity and acceleration.
+     */
+    inline MotionState<T, N> get_state_setpoint() {
+        MotionState<T, N> state;
+
+        next_motion();
+        evaluate_state(motion_pos, state);
+
+        if (blend_motion())
+            superpose(blend_state(), state);
+
+        return state;
+    }
+
+    /**
+     * The remaining states as a lazy input range, see SampleRange.
+     * The calls of the range are not virtual, also when called on a Motion.
+     * 
+     * @return SampleRange over the states.
+     */
+    SampleRange<BasicMotion<T, N, Q, B, P>> samples() {
+        return SampleRange<BasicMotion<T, N, Q, B, P>>(*this);
+    }
+
+#if MOTION_COROUTINES
+    /**
+     * Coroutine variant of samples().
+     * 
+     * @return Generator which yields the states.
+     */
+    Generator<MotionState<T, N>> sample_generator() {
+        do {
+            MotionState<T, N> state {get_state_setpoint()};
+            co_yield state;
+        } while (increment_motion_sample());
+    }
+#endif
+
+    /**
+     * Fill a block of acceleration setpoints. Equivalent to calling 
+     * get_acceleration_setpoint() and increment_motion_sample() for each sample,
+     * but without the per sample overhead. Writing stops after the last sample
+     * of the motion, as increment_motion_sample() would return false there.
+     * 
+     * @param out   Buffer of at least count samples.
+     * @param count Maximum amount of samples to write.
+     * @return Amount of samples written.
+     */
+    size_t fill_acceleration_setpoints(std::array<T, N>* out, size_t count) {
+        return fill_setpoints(out, count, [this](int n, size_t c, std::array<T, N>* o) {
+            current_motion.get_acceleration(n, c, o);
+        }, [](const MotionState<T, N>& blended, std::array<T, N>& o) {
+            o = ml::add_expr(o, blended.acceleration);
+        });
+    }
+
+    /**
+     * Fill a block of velocity setpoints. See fill_acceleration_setpoints().
+     * 
+     * @param out   Buffer of at least count samples.
+     * @param count Maximum amount of samples to write.
+     * @return Amount of samples written.
+     */
+    size_t fill_velocity_setpoints(std::array<T, N>* out, size_t count) {
+        return fill_setpoints(out, count, [this](int n, size_t c, std::array<T, N>* o) {
+            current_motion.get_velocity(n, c, o);
+        }, [](const MotionState<T, N>& blended, std::array<T, N>& o) {
+            o = ml::add_expr(o, blended.velocity);
+        });
+    }
+
+    /**
+     * Fill a block of position setpoints. See fill_acceleration_setpoints().
+     * 
+     * @param out   Buffer of at least count samples.
+     * @param count Maximum amount of samples to write.
+     * @return Amount of samples written.
+     */
+    size_t fill_position_setpoints(std::array<T, N>* out, size_t count) {
+        return fill_setpoints(out, count, [this](int n, size_t c, std::array<T, N>* o) {
+            current_motion.get_position(n, c, o);
+        }, [](const MotionState<T, N>& blended, std::array<T, N>& o) {
+            o = ml::add_expr(o, blended.position);
+        });
+    }
+
+    /**
+     * Fill a block of states. See fill_acceleration_setpoints().
+     * 
+     * @param out   Buffer of at least count samples.
+     * @param count Maximum amount of samples to write.
+     * @return Amount of samples written.
+     */
+    size_t fill_state_setpoints(MotionState<T, N>* out, size_t count) {
+        return fill_setpoints(out, count, [this](int n, size_t c, MotionState<T, N>* o) {
+            if (stepping_interval > 0) {
+                for (size_t k = 0; k < c; k++)
+                    current_motion.get_state(n + static_cast<int>(k), stepper, stepping_interval, o[k]);
+            }
+            else {
+                current_motion.get_state(n, c, o);
+            }
+        }, [](const MotionState<T, N>& blended, MotionState<T, N>& o) {
+            superpose(blended, o);
+        });
+    }
+
+    /**
+     * Evaluate the states with forward differences instead of the full polynomials.
+     * Every interval samples the differences are re-anchored on the exact polynomials,
+     * which bounds the drift. Only applies to get_state_setpoint() and fill_state_setpoints().
+     * 
+     * @param interval  Amount of samples between re-anchors, 0 disables stepping.
+     */
+    void set_stepping(int interval) {
+        stepping_interval = interval;
+        stepper.reset();
+    }
+
+    /**
+     * Time of the sample which is returned next, counted from the first sample.
+     * 
+     * @return Time in seconds.
+     */
+    inline T sample_time() const {
+        return (current_motion.start + motion_pos) * this->dt;
+    }
+
+    /**
+     * Get the state at an arbitrary time of the planned trajectory without advancing the motion.
+     * The motion which contains the time is found with a binary search over the start samples
+     * of the queued motions. Times of the current motion remain available until it is finished,
+     * in a blended corner the previous motion remains available until the overlap is finished.
+     * With SpscQueue it must be called from the sampling thread.
+     * 
+     * @param t     Time in seconds counted from the first sample, see sample_time().
+     * @param out   State which receives the values of all dimensions.
+     * @return False when the time is no longer or not yet planned.
+     */
+    bool state_at(T t, MotionState<T, N>& out) const {
+        T s {t * this->hz};
+        MotionObject<T, N> m, previous;
+
+        if (!find_motion(static_cast<long long>(std::floor(s)), m, previous))
+            return false;
+
+        m.get_state_at(this->dt * (s - m.start), out);
+
+        if (previous.dt > 0) {
+            MotionState<T, N> state;
+            previous.get_state_at(this->dt * (s - previous.start), state);
+            superpose_previous(state, m, out);
+        }
+
+        return true;
+    }
+
+    /**
+     * Variant of state_at() at a sample, the result equals the state the sampling functions return.
+     * 
+     * @param k     Sample counted from the first sample.
+     * @param out   State which receives the values of all dimensions.
+     * @return False when the sample is no longer or not yet planned.
+     */
+    bool state_at_sample(long long k, MotionState<T, N>& out) const {
+        MotionObject<T, N> m, previous;
+
+        if (!find_motion(k, m, previous))
+            return false;
+
+        m.get_state_at(this->dt * static_cast<int>(k - m.start), out);
+
+        if (previous.dt > 0) {
+            MotionState<T, N> state;
+            previous.get_state_at(this->dt * static_cast<int>(k - previous.start), state);
+            superpose_previous(state, m, out);
+        }
+
+        return true;
+    }
+
+    BasicMotion<T, N, Q, B, P>& operator= (BasicMotion<T, N, Q, B, P>&& mp) {
+        this->hz = mp.hz;
+        this->dt = mp.dt;
+        return *this;
+    }
+
+    void set_hz(int hz) {
+        this->hz = hz;
+    }
+
+private:
+    /**
+     * Advance to the next queued motion when the current motion exceeds its amount of samples.
+     */
+    inline void next_motion() {
         // When motions are queued and the current motion exceeds amount of samples, get a new motion.
         if ((this->motion_queue_size() > 0) && (motion_pos >= current_motion.n)) {
+            // The overlapping samples of a blended motion were superposed on the current motion.
+            // After a hold, or when the overlap was refused (see find_blend_start()), the current 
+            // motion did not overlap and the motion starts at its first sample.
+            int blended {motion_pos == current_motion.n && blend_start < current_motion.n ? next_blend() : 0};
+            if (blended > 0)
+                previous_motion = current_motion;
+            else
+                previous_motion.dt = 0;
+
             motion_in_progress = true;
             current_motion = this->get_motion();
-            motion_pos = 0;
+            MOTION_STATISTICS(this->statistics.record_switch());
+            motion_pos = blended;
+            blend_start = blend_unknown;
+            stepper.reset();
         }  
         // When the queue is empty and motion is finished, no more actions are nescecary.
         else if ((this->motion_queue_size() == 0) && (motion_pos >= current_motion.n)){
             motion_in_progress = false;
             motion_pos = current_motion.n + 1;
         }
+    }
 
-        for (size_t i = 0; i < N; i++)
-            positions[i] = current_motion.get_position(motion_pos, i);
+    inline void evaluate_state(int n, MotionState<T, N>& state) {
+        if (stepping_interval > 0)
+            current_motion.get_state(n, stepper, stepping_interval, state);
+        else
+            current_motion.get_state(n, state);
+    }
 
-        return positions;
+    /**
+     * True when the next motion overlaps the current sample, see MotionPlanner::set_blend_tolerance().
+     */
+    inline bool blend_motion() {
+        return motion_pos >= blend_start && find_blend_start();
     }
 
-    Motion<T, N>& operator= (Motion<T, N>&& mp) {
-        this->hz = mp.hz;
-        this->dt = mp.dt;
-        return *this;
+    /**
+     * The first sample of the overlap is known once the next motion is queued. The current motion
+     * is switched at its last sample when the next motion is queued, so it is not checked.
+     * A motion which is queued after sampling entered its overlap, e.g. when streaming or planning
+     * on another thread, is not blended: the skipped samples of the overlap were not superposed. 
+     * Like after a hold, the current motion stops at the corner and the motion starts at its first sample.
+     */
+    bool find_blend_start() {
+        if (blend_start == blend_unknown) {
+            if (this->motion_queue_size() == 0)
+                return false;
+
+            int blend {next_blend()};
+            blend_start = blend > 0 && !blend_refused() ? current_motion.n - blend : std::numeric_limits<int>::max();
+        }
+
+        return motion_pos >= blend_start;
     }
 
-    void set_hz(int hz) {
-        this->hz = hz;
+    /**
+     * True when the queued next motion overlaps the current motion, but sampling passed the start 
+     * of the overlap before it was queued. The queue may not be empty.
+     */
+    bool blend_refused() const {
+        int blend {next_blend()};
+
+        if (blend == 0)
+            return false;
+
+        if (blend_start == blend_unknown)
+            return motion_pos > current_motion.n - blend;
+
+        return blend_start >= current_motion.n;
+    }
+
+    /**
+     * Overlap of the next motion with the current motion, only the first motion of a move overlaps.
+     * The queue may not be empty.
+     */
+    inline int next_blend() const {
+        return this->next_phase() == 0 ? this->peek_move(0).blend : 0;
+    }
+
+    /**
+     * State of the overlapping next motion at the current sample, with its position relative 
+     * to its start point. Only valid when blend_motion() is true.
+     */
+    MotionState<T, N> blend_state() const {
+        const MoveRecord<T, N>& next {this->peek_move(0)};
+        MotionState<T, N> out;
+
+        next.get_state_at(0, this->dt * (motion_pos - (current_motion.n - next.blend)), out);
+        out.position = ml::min_expr(out.position, next.prev_setpoint);
+        return out;
+    }
+
+    static inline void superpose(const MotionState<T, N>& blended, MotionState<T, N>& out) {
+        out.position = ml::add_expr(out.position, blended.position);
+        out.velocity = ml::add_expr(out.velocity, blended.velocity);
+        out.acceleration = ml::add_expr(out.acceleration, blended.acceleration);
+    }
+
+    /**
+     * Superpose the state of the previous motion on the state of motion m in its overlap.
+     */
+    static void superpose_previous(MotionState<T, N> previous, const MotionObject<T, N>& m, MotionState<T, N>& out) {
+        previous.position = ml::min_expr(previous.position, m.prev_setpoint);
+        superpose(previous, out);
+    }
+
+    /**
+     * Motion which contains sample k. The motion is found with a binary search over the start 
+     * samples of the queued moves, followed by the phases of the move. A motion without samples 
+     * still takes one sample, see next_motion().
+     * 
+     * @param m         Receives the motion which contains k.
+     * @param previous  Receives the previous motion when k is in the overlap of a blended motion, 
+     *                  otherwise its dt is 0.
+     * @return False when sample k is no longer or not yet planned.
+     */
+    bool find_motion(long long k, MotionObject<T, N>& m, MotionObject<T, N>& previous) const {
+        size_t size {static_cast<size_t>(this->motion_queue_size())};
+        bool refused {size > 0 && blend_refused()};
+        previous.dt = 0;
+
+        // A refused overlap is sampled with the current motion only, see find_blend_start().
+        if (size == 0 || k < this->peek_move(0).phase_start(this->next_phase()) 
+            || (refused && k < current_motion.start + std::max(current_motion.n, 1))) {
+            bool sampled {current_motion.dt > 0};
+            if (!sampled || k < current_motion.start || k >= current_motion.start + std::max(current_motion.n, 1))
+                return false;
+
+            m = current_motion;
+            if (k < current_motion.start + current_motion.blend && previous_motion.dt > 0)
+                previous = previous_motion;
+            return true;
+        }
+
+        // Last queued move which starts at or before k.
+        size_t low {0}, high {size};
+        while (high - low > 1) {
+            size_t mid {low + (high - low) / 2};
+            if (this->peek_move(mid).start <= k)
+                low = mid;
+            else
+                high = mid;
+        }
+
+        const MoveRecord<T, N>& move {this->peek_move(low)};
+        if (k >= move.end())
+            return false;
+
+        int i {move.phase_at(k)};
+        move.get_motion(i, m);
+
+        if (i == 0 && k < move.start + move.blend && !(low == 0 && refused)) {
+            if (low > 0) {
+                const MoveRecord<T, N>& before {this->peek_move(low - 1)};
+                before.get_motion(before.phases - 1, previous);
+            }
+            else {
+                previous = current_motion;
+            }
+        }
+
+        return true;
+    }
+
+    template <typename S, typename F, typename G>
+    size_t fill_setpoints(S* out, size_t count, F evaluate, G superpose_blended) {
+        size_t written = 0;
+
+        while (written < count) {
+            next_motion();
+
+            // No motion switch can occur before the current motion runs out of samples,
+            // so the remaining samples of the motion are evaluated as one run. Samples which
+            // overlap a blended next motion are superposed one by one.
+            size_t run {1};
+            if (motion_pos < current_motion.n) {
+                int end {current_motion.n};
+
+                if (blend_motion())
+                    end = motion_pos + 1;
+                else if (blend_start != blend_unknown)
+                    end = std::min(end, blend_start);
+
+                run = std::min(count - written, static_cast<size_t>(end - motion_pos));
+            }
+
+            evaluate(motion_pos, run, out + written);
+
+            if (run == 1 && blend_motion())
+                superpose_blended(blend_state(), out[written]);
+
+            written += run;
+            MOTION_STATISTICS(this->statistics.record_samples(run));
+            motion_pos += static_cast<int>(run);
+
+            if (!motion_in_progress)
+                break;
+        }
+
+        return written;
     }
 
-private:
     MotionObject<T, N> current_motion;
+    PolynomialStepper<T> stepper;
     std::array<T, N> p_init;
     int motion_pos = 0;
+    int stepping_interval = 0;
+    // First sample of the current motion which overlaps the next motion.
+    static constexpr int blend_unknown = std::numeric_limits<int>::min();
+    int blend_start = blend_unknown;
+
+    // Motion before the current motion, kept while a blended corner is sampled for state_at().
+    MotionObject<T, N> previous_motion;
 
 };
 
+/**
+ * Motion with a virtual sampling interface, which allows the sampling functions to be overridden.
+ * When that is not required BasicMotion avoids the virtual calls.
+ */
+template <typename T, size_t N, typename Q = std::queue<MoveRecord<T, N>>, 
+          typename B = SetpointBuffer<T, N>, typename P = SmoothProfile<T>>
+class Motion : public BasicMotion<T, N, Q, B, P> {
+public:
+    using BasicMotion<T, N, Q, B, P>::BasicMotion;
+
+    virtual ~Motion() {}
+
+    virtual inline bool increment_motion_sample() {
+        return BasicMotion<T, N, Q, B, P>::increment_motion_sample();
+    }
+
+    virtual std::array<T, N> get_acceleration_setpoint() {
+        return BasicMotion<T, N, Q, B, P>::get_acceleration_setpoint();
+    }
+
+    inline virtual std::array<T, N> get_velocity_setpoint() {
+        return BasicMotion<T, N, Q, B, P>::get_velocity_setpoint();
+    }
+
+    virtual std::array<T, N> get_position_setpoint() {
+        return BasicMotion<T, N, Q, B, P>::get_position_setpoint();
+    }
+
+    virtual MotionState<T, N> get_state_setpoint() {
+        return BasicMotion<T, N, Q, B, P>::get_state_setpoint();
+    }
+
+    Motion<T, N, Q, B, P>& operator= (Motion<T, N, Q, B, P>&& mp) {
+        BasicMotion<T, N, Q, B, P>::operator=(std::move(mp));
+        return *this;
+    }
+};
+
 #endif
\ No newline at end of file
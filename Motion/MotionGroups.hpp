@@ -0,0 +1,232 @@
+/**
+ * Copyright (c) 2020 Bas Brussen
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.                                                                         
+ * 
+ * 
+ * @file MotionGroups.hpp
+ *
+ * @brief Motion groups sample many independent groups of axes with one update.
+ *
+ * @author Bas Brussen
+ * Contact: b.brussen@outlook.com
+ *
+ */
+
+#ifndef MotionGroups_hpp
+#define MotionGroups_hpp
+
+#include <memory>
+#include <vector>
+
+#include "Motion.hpp"
+
+/**
+ * Every group is planned with its own BasicMotion. The active motions of all groups are stored
+ * as a structure of arrays, so one update evaluates the polynomials of multiple groups per 
+ * instruction with the packs of ml::simd. A coasting motion is stored as a polynomial without
+ * constants, which equals the coast of MotionObject up to rounding. Blended corners are not 
+ * superposed, the motions of a corner are sampled one after the other.
+ * 
+ * Template arguments:
+ * @param T     Type of the scalar.
+ * @param N     Number of dimensions of each group.
+ * @param Q     Queue which stores the moves of each group.
+ */
+template <typename T, size_t N, typename Q = std::queue<MoveRecord<T, N>>>
+class MotionGroups {
+public:
+    MotionGroups(size_t groups, int hz) : 
+        MotionGroups(groups, hz, std::array<T, N>{}) {}
+
+    MotionGroups(size_t groups, int hz, std::array<T, N> p) : 
+        dt(T(1) / hz),
+        pos(groups, 0), n(groups, 0), in_progress(groups, 0),
+        time(groups), c_3(groups), c_4(groups), c_5(groups), c_6(groups), v_0(groups), p_0(groups),
+        p(groups), v(groups), a(groups),
+        unit_vector(N * groups), prev_setpoint(N * groups),
+        position(N * groups), velocity(N * groups), acceleration(N * groups) {
+        for (size_t k = 0; k < groups; k++)
+            planners.emplace_back(new BasicMotion<T, N, Q>(hz, p));
+
+        // The arrays are indexed with the amount of groups, so all planners are created first.
+        for (size_t k = 0; k < groups; k++) {
+            load(k, MotionObject<T, N>());
+
+            for (size_t i = 0; i < N; i++)
+                prev_setpoint[i * groups + k] = p[i];
+        }
+    }
+
+    /**
+     * Planner of a group, motions are planned with its plan functions.
+     * 
+     * @param k     Group.
+     */
+    BasicMotion<T, N, Q>& group(size_t k) {
+        return *planners[k];
+    }
+
+    size_t size() const {
+        return planners.size();
+    }
+
+    /**
+     * Evaluate the current sample of all groups and advance them to their next sample, 
+     * equal to get_state_setpoint() and increment_motion_sample() of a single motion.
+     * 
+     * @return Amount of groups with a motion in progress.
+     */
+    size_t update() {
+        const size_t groups {size()};
+
+        for (size_t k = 0; k < groups; k++) {
+            next_motion(k);
+            time[k] = dt * pos[k];
+        }
+
+        using P = ml::simd::pack<T>;
+
+        size_t k = 0;
+        for (; k + P::width <= groups; k += P::width)
+            evaluate<P>(k);
+
+        for (; k < groups; k++)
+            evaluate<ml::simd::scalar<T>>(k);
+
+        for (size_t i = 0; i < N; i++) {
+            const size_t d {i * groups};
+
+            for (size_t j = 0; j < groups; j++) {
+                position[d + j] = (p[j] * unit_vector[d + j]) + prev_setpoint[d + j];
+                velocity[d + j] = v[j] * unit_vector[d + j];
+                acceleration[d + j] = a[j] * unit_vector[d + j];
+            }
+        }
+
+        size_t active {0};
+        for (size_t j = 0; j < groups; j++) {
+            pos[j]++;
+            active += in_progress[j];
+        }
+
+        return active;
+    }
+
+    /**
+     * Setpoints of dimension i of all groups, evaluated by the last update.
+     * 
+     * @param i     Dimension.
+     */
+    const T* get_position_setpoints(size_t i) const {
+        return position.data() + i * size();
+    }
+
+    const T* get_velocity_setpoints(size_t i) const {
+        return velocity.data() + i * size();
+    }
+
+    const T* get_acceleration_setpoints(size_t i) const {
+        return acceleration.data() + i * size();
+    }
+
+    /**
+     * State of a group, evaluated by the last update.
+     * 
+     * @param k     Group.
+     * @param out   State which receives the values of all dimensions.
+     */
+    void get_state_setpoint(size_t k, MotionState<T, N>& out) const {
+        for (size_t i = 0; i < N; i++) {
+            out.position[i] = position[i * size() + k];
+            out.velocity[i] = velocity[i * size() + k];
+            out.acceleration[i] = acceleration[i * size() + k];
+        }
+    }
+
+    bool motion_in_progress(size_t k) const {
+        return in_progress[k];
+    }
+
+private:
+    /**
+     * Advance group k to its next queued motion when the current motion exceeds its amount of samples.
+     */
+    inline void next_motion(size_t k) {
+        if (pos[k] < n[k])
+            return;
+
+        BasicMotion<T, N, Q>& planner {*planners[k]};
+
+        if (planner.motion_queue_size() > 0) {
+            load(k, planner.get_motion());
+            in_progress[k] = 1;
+            pos[k] = 0;
+        }
+        else {
+            in_progress[k] = 0;
+            pos[k] = n[k] + 1;
+        }
+    }
+
+    void load(size_t k, const MotionObject<T, N>& m) {
+        c_3[k] = m.is_coast ? 0 : m.c_3;
+        c_4[k] = m.is_coast ? 0 : m.c_4;
+        c_5[k] = m.is_coast ? 0 : m.c_5;
+        c_6[k] = m.is_coast ? 0 : m.c_6;
+        v_0[k] = m.is_coast ? m.v_target : m.v_0;
+        p_0[k] = m.p_0;
+        n[k] = m.n;
+
+        for (size_t i = 0; i < N; i++) {
+            unit_vector[i * size() + k] = m.unit_vector[i];
+            prev_setpoint[i * size() + k] = m.prev_setpoint[i];
+        }
+    }
+
+    template <typename P>
+    inline void evaluate(size_t k) {
+        const ml::simd::coefficients<P, T> c(P::load(&c_3[k]), P::load(&c_4[k]), P::load(&c_5[k]), 
+                                             P::load(&c_6[k]), P::load(&v_0[k]), P::load(&p_0[k]));
+        const P t {P::load(&time[k])};
+
+        c.position(t).store(&p[k]);
+        c.velocity(t).store(&v[k]);
+        c.acceleration(t).store(&a[k]);
+    }
+
+    std::vector<std::unique_ptr<BasicMotion<T, N, Q>>> planners;
+    T dt;
+
+    // Sample and amount of samples of the active motion of each group.
+    std::vector<int> pos, n;
+    std::vector<unsigned char> in_progress;
+
+    // Active motion of each group, one array per constant.
+    std::vector<T> time, c_3, c_4, c_5, c_6, v_0, p_0;
+
+    // Scalar position, velocity and acceleration along the unit vector.
+    std::vector<T> p, v, a;
+
+    // Arrays with N * groups values, dimension after dimension.
+    std::vector<T> unit_vector, prev_setpoint;
+    std::vector<T> position, velocity, acceleration;
+};
+
+#endif
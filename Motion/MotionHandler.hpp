@@ -32,40 +32,149 @@
 #define MotionHandler_hpp
 
 #include "Definitions.hpp"
+#include "SegmentQueue.hpp"
+#include "Instrumentation.hpp"
 #include <queue>
 
-template <typename T, size_t N>
+/**
+ * Template arguments:
+ * @param T     Type of the scalar.
+ * @param N     Number of dimensions.
+ * @param Q     Queue which stores the moves, see MoveRecord. SpscQueue allows planning and sampling from 
+ *              different threads, FixedQueue is a single threaded queue which does not allocate.
+ */
+template <typename T, size_t N, typename Q = std::queue<MoveRecord<T, N>>>
 class MotionHandler{
 public:
     MotionHandler () :
         motion_length(0) {}
 
-    virtual ~MotionHandler() {}
+    /**
+     * Append a motion to the move which is being planned. A motion of another segment starts 
+     * a new move, the previous move is queued. The last move is queued by end_move().
+     * 
+     * @return False when the previous move does not fit in a queue with a fixed capacity,
+     *         the motion is not appended.
+     */
+    bool append_motion (MotionObject<T, N>& m) {
+        // A motion without samples still takes one sample, see BasicMotion::next_motion().
+        m.start = timeline_end - m.blend;
 
-    void append_motion (MotionObject<T, N>& m) {
+        if (!pending.append(m)) {
+            if (!end_move())
+                return false;
+
+            pending.append(m);
+        }
+
+        timeline_end = m.start + std::max(m.n, 1);
         motion_length += (m.n + 1);
-        motion_queue.push(std::move(m));
+        return true;
     }
 
-    int motion_queue_size () {
+    /**
+     * Queue the move of the appended motions, the samplers only see queued moves.
+     * 
+     * @return False when the move does not fit in a queue with a fixed capacity, 
+     *         the move stays pending.
+     */
+    bool end_move () {
+        if (pending.phases == 0)
+            return true;
+
+        if (!queue_traits<Q>::push(motion_queue, pending))
+            return false;
+
+        pending.phases = 0;
+        pending.coast = 0;
+        return true;
+    }
+
+    /**
+     * Amount of queued moves with motions which are not sampled yet.
+     */
+    int motion_queue_size () const {
         return motion_queue.size();
     }
 
+    /**
+     * Amount of moves that can still be queued, a move which is being appended takes one. 
+     * A plan call queues one move, which has to fit when a queue with a fixed capacity is used.
+     */
+    size_t motion_queue_space () {
+        return queue_traits<Q>::capacity - motion_queue.size() - (pending.phases > 0 ? 1 : 0);
+    }
+
+    /**
+     * Take the next motion to sample, the move is removed from the queue after its last motion.
+     */
     MotionObject<T, N> get_motion () {
+        MotionObject<T, N> m;
+
         if (motion_queue.size() > 0) {
-            MotionObject<T, N> move = std::move(motion_queue.front());
-            motion_queue.pop();
-            motion_length -= (move.n + 1);
-            return move;
+            const MoveRecord<T, N>& move {motion_queue.front()};
+            move.get_motion(move_phase, m);
+
+            if (++move_phase == move.phases) {
+                motion_queue.pop();
+                move_phase = 0;
+            }
+
+            motion_length -= (m.n + 1);
         }
 
-        return MotionObject<T, N>();
+        return m;
     }
 
-    int motion_length;
+    /**
+     * Remove the first queued move with its motions which are not taken yet.
+     */
+    void pop_move () {
+        const MoveRecord<T, N>& move {motion_queue.front()};
+
+        for (int i = move_phase; i < move.phases; i++)
+            motion_length -= (move.n[i] + 1);
+
+        motion_queue.pop();
+        move_phase = 0;
+    }
+
+    /**
+     * Queued move i positions after the first queued move, i must be smaller than motion_queue_size().
+     * With SpscQueue only available on the sampling thread.
+     */
+    const MoveRecord<T, N>& peek_move (size_t i) const {
+        return queue_traits<Q>::at(motion_queue, i);
+    }
+
+    /**
+     * First motion of the first queued move which is not taken by get_motion().
+     */
+    int next_phase () const {
+        return move_phase;
+    }
+
+    typename queue_traits<Q>::length_type motion_length;
+
+#if MOTION_INSTRUMENTATION
+    // Statistics of the planner and sampler, can be read from any thread with statistics.snapshot().
+    MotionStatistics statistics;
+#endif
+
+protected:
+    // Not meant to be deleted through a base pointer, so no virtual destructor is required.
+    ~MotionHandler() {}
 
 private:
-    std::queue<MotionObject<T, N>> motion_queue;
+    Q motion_queue;
+
+    // Move which is being appended, only used by the planner.
+    MoveRecord<T, N> pending;
+    // Motions of the first queued move which are taken, only used by the sampler.
+    int move_phase {0};
+
+    // First sample of the next appended motion, counted from the first planned motion.
+    long long timeline_end {0};
 };
 
 #endif
\ No newline at end of file
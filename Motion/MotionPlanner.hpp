@@ -31,107 +31,619 @@
 #ifndef MotionPlanner_hpp
 #define MotionPlanner_hpp
 
+#include <limits>
+#include <thread>
+#include <vector>
+
 #include "SetpointBuffer.hpp"
 #include "MotionHandler.hpp"
 
-template <typename T, size_t N>
-class MotionPlanner : public MotionHandler<T, N>, public SetpointBuffer<T, N> {
+/**
+ * Planner of the motions between the appended points. The storage of the moves, the points and 
+ * the shape of the velocity changes are policies, which are resolved at compile time.
+ * 
+ * Template arguments:
+ * @param T     Type of the scalar.
+ * @param N     Number of dimensions.
+ * @param Q     Queue policy which stores the moves, see MotionHandler.
+ * @param B     Buffer policy which holds the last three points in mp_buffer and shifts in a point 
+ *              with append_buffer(), see SetpointBuffer.
+ * @param P     Profile policy with velocity_change() and the peak ratios, see SmoothProfile.
+ */
+template <typename T, size_t N, typename Q = std::queue<MoveRecord<T, N>>, 
+          typename B = SetpointBuffer<T, N>, typename P = SmoothProfile<T>>
+class MotionPlanner : public MotionHandler<T, N, Q>, public B {
 public:
     int hz;
     T dt;
 
     MotionPlanner(const int hz) : 
         hz(hz), 
-        dt(1./hz) { }
+        dt(T(1) / hz) { }
 
     MotionPlanner(const int hz, std::array<T, N>& point) : 
-        SetpointBuffer<T, N>(point),
+        B(point),
         hz(hz), 
-        dt(1./hz) { }
+        dt(T(1) / hz) { }
 
-    virtual ~MotionPlanner(){};
+    /**
+     * Append a point and plan the segment which it completes, see BasicMotion::plan().
+     * A plan call queues at most one move. A queue which rejects moves when it is full must 
+     * have room for it, see MotionHandler::motion_queue_space().
+     * 
+     * @return False when the queue is full, the point is not appended. Plan it again after 
+     *         the sampler made room.
+     */
+    bool append_and_plan(const Point<T, N>& p){
+        if (!queue_has_room())
+            return false;
+
+        MOTION_STATISTICS(auto plan_start = MotionStatistics::clock::now());
 
-    void append_and_plan(const Point<T, N>& p){
         // First append required to fill buffer.
         this->append_buffer(p);
-        plan_motion();
+        rejected = false;
+
+        if (look_ahead.empty())
+            plan_motion();
+        else
+            plan_look_ahead(p.velocity);
+
+        bool queued {this->end_move() && !rejected};
+        MOTION_STATISTICS(this->statistics.record_plan(plan_start, this->motion_queue_size(), this->motion_length));
+        return queued;
     }
 
-    void append_and_plan(const Point<T, N>& p, T& v_final){
+    bool append_and_plan(const Point<T, N>& p, T& v_final){
+        if (!queue_has_room())
+            return false;
+
+        MOTION_STATISTICS(auto plan_start = MotionStatistics::clock::now());
+
         // First append required to fill buffer.
         this->append_buffer(p);
-        plan_motion(v_final);
+        rejected = false;
+
+        if (look_ahead.empty())
+            plan_motion(v_final);
+        else
+            plan_look_ahead(v_final);
+
+        bool queued {this->end_move() && !rejected};
+        MOTION_STATISTICS(this->statistics.record_plan(plan_start, this->motion_queue_size(), this->motion_length));
+        return queued;
+    }
+
+    /**
+     * Enable look-ahead planning. Segments are kept in a window in which the junction velocities 
+     * are maximized with a backward pass (every segment must be able to stop at the end of the window) 
+     * and a forward pass (every exit velocity must be reachable from the entry velocity). 
+     * The oldest segment is queued when the window is full, call flush() after the last point.
+     * With look-ahead, the final velocity of a plan call limits the velocity at that point.
+     * 
+     * @param segments  Size of the window, 0 restores planning from three points.
+     * @return False when the segments in the window do not fit in the queue, see flush(). 
+     *         The window is not changed.
+     */
+    bool set_look_ahead(size_t segments) {
+        if (!flush())
+            return false;
+
+        look_ahead.assign(segments, LookAheadSegment());
+        look_ahead_first = 0;
+        return true;
+    }
+
+    /**
+     * Limit the jerk of the planned motions. Every segment is solved directly for the shortest
+     * profile which respects the velocity, acceleration and jerk limits and ends exactly at its 
+     * end point, instead of scaling the transition until it fits. Applies to planning from 
+     * three points, not to look-ahead.
+     * 
+     * @param jerk  Jerk limit, 0 restores the transition planner.
+     */
+    void set_jerk_limit(T jerk) {
+        jerk_limit = jerk;
+    }
+
+    /**
+     * Blend the corners between segments. Every segment is planned from rest to rest and the first 
+     * motion of a segment starts during the last motion of the previous segment, the samplers 
+     * superpose both. The overlap is the longest for which the path stays within the tolerance of 
+     * the segments, so the corner is rounded and the stop at the corner is removed. In the overlap 
+     * the velocity and acceleration are the vector sum of both motions, up to the sum of the limits 
+     * of both segments. Applies to planning from three points, not to look-ahead, and combines 
+     * with the jerk limit. A segment which is planned after sampling entered its overlap, for 
+     * example by a second thread, starts after the previous segment without blending. The search 
+     * for the overlap keeps buffers as long as the longest motion, so planning with blending may 
+     * allocate until they reach that length.
+     * 
+     * @param tolerance Largest distance between the blended path and the segments, 0 disables blending.
+     */
+    void set_blend_tolerance(T tolerance) {
+        blend_tolerance = tolerance;
     }
 
+    /**
+     * Queue all segments in the look-ahead window, the last segment stops at its end point.
+     * Every segment is queued as one move.
+     * 
+     * @return False when the queue is full before the window is empty, the remaining segments 
+     *         stay in the window. Flush again after the sampler made room.
+     */
+    bool flush() {
+        while (look_ahead_size > 0) {
+            if (!queue_has_room())
+                return false;
+
+            rejected = false;
+            emit_look_ahead();
+
+            if (!this->end_move() || rejected)
+                return false;
+        }
+
+        return true;
+    }
+
+    /**
+     * Plan a list of points, equal to calling append_and_plan() for every point, with the final 
+     * velocity of the points which have one. The geometry and deceleration phase of each segment 
+     * only depend on the points and are calculated on multiple threads, the entry velocities are 
+     * linked afterwards in a sequential pass. The queued moves are identical to sequential planning. 
+     * In look-ahead mode the points are planned sequentially.
+     * 
+     * A plan call queues one move, with a queue of a fixed capacity only the points which fit in
+     * motion_queue_space() are planned. Plan the remaining points after the sampler made room.
+     * 
+     * @param points    Points to plan.
+     * @param threads   Amount of threads, 0 uses the amount of hardware threads.
+     * @return Amount of points planned, from the start of the list.
+     */
+    size_t plan_batch(const std::vector<Point<T, N>>& points, unsigned threads = 0) {
+        return plan_batch(points.data(), points.size(), threads);
+    }
+
+    size_t plan_batch(const Point<T, N>* points, size_t count, unsigned threads = 0) {
+        count = std::min(count, this->motion_queue_space());
+
+        if (!look_ahead.empty()) {
+            for (size_t i = 0; i < count; i++) {
+                T v_final {points[i].v_final};
+                bool queued {points[i].has_final ? append_and_plan(points[i], v_final) : append_and_plan(points[i])};
+
+                if (!queued)
+                    return i;
+            }
+
+            return count;
+        }
+
+        std::vector<SegmentGeometry> segments(count);
+
+        // Planning point i uses the two points before it, which are still in the buffer for the first points.
+        auto point = [&](long i) -> const Point<T, N>& {
+            return i < 0 ? this->mp_buffer[3 + i] : points[i];
+        };
+
+        auto solve = [&](size_t first, size_t last) {
+            Polynomial<T> scratch;
+
+            for (size_t i = first; i < last; i++) {
+                long k {static_cast<long>(i)};
+                segments[i] = segment_geometry(point(k - 2), point(k - 1), point(k), scratch);
+
+                // The final velocity of a point replaces the exit velocity of the corner, see plan_motion(v_final).
+                if (points[i].has_final)
+                    final_velocity(segments[i], points[i].v_final, scratch);
+            }
+        };
+
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+
+        // Small batches are not worth starting threads for.
+        threads = static_cast<unsigned>(std::min<size_t>(threads, count / min_batch_chunk + 1));
+
+        std::vector<std::thread> workers;
+        size_t chunk {(count + threads - 1) / threads};
+
+        for (unsigned t = 1; t < threads; t++)
+            workers.emplace_back(solve, std::min(count, t * chunk), std::min(count, (t + 1) * chunk));
+
+        solve(0, std::min(count, chunk));
+
+        for (auto& worker : workers)
+            worker.join();
+
+        // The parallel part is not included in the recorded plan durations.
+        for (size_t i = 0; i < count; i++) {
+            MOTION_STATISTICS(auto plan_start = MotionStatistics::clock::now());
+
+            this->append_buffer(points[i]);
+            plan_motion(segments[i]);
+            this->end_move();
+
+            MOTION_STATISTICS(this->statistics.record_plan(plan_start, this->motion_queue_size(), this->motion_length));
+        }
+
+        return count;
+    }
+
+protected:
+    ~MotionPlanner() {}
+
 private:
+    // Peak acceleration and jerk of a velocity transition, see SmoothProfile.
+    static constexpr T accel_peak_ratio = P::accel_peak_ratio;
+    static constexpr T jerk_peak_ratio = P::jerk_peak_ratio;
+
+    struct LookAheadSegment {
+        std::array<T, N> start {};
+        std::array<T, N> unit_vector {};
+        T length {0};
+        T v_target {0};
+        T a_target {0};
+        T v_junction {0};   // Maximum velocity at the end of the segment.
+        T v_exit {0};       // Exit velocity that still allows to stop at the end of the window.
+    };
+
+    /**
+     * True when a move can be queued, a queue which does not reject moves waits for room.
+     */
+    bool queue_has_room() {
+        return !queue_traits<Q>::rejects_when_full || this->motion_queue_space() > 0;
+    }
+
+    // Smallest amount of points planned per thread by plan_batch().
+    static constexpr size_t min_batch_chunk = 1024;
+
+    /**
+     * Part of a planned motion which only depends on its three points.
+     */
+    struct SegmentGeometry {
+        std::array<T, N> delta_unit {};
+        T carthesian_delta {0};
+        T v_exit {0};
+        T v_target {0};
+        T a_target {0};
+        T t_dec {0};
+        T p_dec {0};
+    };
+
     MotionObject<T, N> current_motion;   
 
     T v_enter {0.0};
     T error {0.0};
+    T jerk_limit {0.0};
+    T blend_tolerance {0.0};
+    // A motion of the plan call was not appended, see update_motion().
+    bool rejected {false};
+
+    // Last queued motion, the motion which the next segment blends with.
+    MotionObject<T, N> previous_phase;
+    // The next appended motion is the first motion of a segment which blends with previous_phase.
+    bool blend_next {false};
+    // Distances along the motions of a corner, see blend_samples().
+    std::vector<T> blend_tail;
+    std::vector<T> blend_head;
+
+    std::vector<LookAheadSegment> look_ahead;
+    size_t look_ahead_first {0};
+    size_t look_ahead_size {0};
+    T look_ahead_error {0.0};
+
+    LookAheadSegment& look_ahead_at(size_t i) {
+        return look_ahead[(look_ahead_first + i) % look_ahead.size()];
+    }
+
+    /**
+     * Highest velocity reachable from v over a distance, constrained by acceleration.
+     */
+    static T reachable_velocity(T v, T a_target, T distance) {
+        return std::sqrt(v * v + 2 * a_target * distance / accel_peak_ratio);
+    }
+
+    /**
+     * Highest velocity reachable from v over a distance within the window. Compared to reachable_velocity()
+     * the distance of one sample at the reached velocity is kept in reserve, which leaves plan_segment() 
+     * room to round the phases to whole samples and still end at the end point.
+     */
+    T look_ahead_velocity(T v, T a_target, T distance) const {
+        T v_sample {a_target / accel_peak_ratio * dt};
+        return std::sqrt(v_sample * v_sample + v * v + 2 * a_target * distance / accel_peak_ratio) - v_sample;
+    }
+
+    void plan_look_ahead(T v_final) {
+        auto m = ml::min_expr(this->mp_buffer[2].setpoint, 
+                         this->mp_buffer[1].setpoint);
+        T length {std::sqrt(ml::dot(m, m))};
+
+        if (length < T(1e-9))
+            return;
+
+        LookAheadSegment segment;
+        segment.start = this->mp_buffer[1].setpoint;
+        segment.unit_vector = ml::div_expr(m, length);
+        segment.length = length;
+        segment.v_target = this->mp_buffer[2].velocity;
+        segment.a_target = this->mp_buffer[2].acceleration;
+        segment.v_junction = std::min(v_final, segment.v_target);
+
+        if (look_ahead_size > 0) {
+            LookAheadSegment& last = look_ahead_at(look_ahead_size - 1);
+
+            // Corner velocity ratio from the angle between the segments, 0.01 is the smallest ratio allowed.
+            T cos_angle {ml::dot(last.unit_vector, segment.unit_vector)};
+            T ratio {std::max(static_cast<T>(0.01), cos_angle > 0 ? cos_angle * cos_angle * cos_angle : static_cast<T>(0))};
+
+            last.v_junction = std::min(last.v_junction, std::min(last.v_target, segment.v_target) * ratio);
+        }
+
+        if (look_ahead_size == look_ahead.size())
+            emit_look_ahead();
+
+        look_ahead_at(look_ahead_size++) = segment;
+
+        // Backward pass from the new tail, stops as soon as an exit velocity is unaffected.
+        for (size_t i = look_ahead_size - 1; i-- > 0;) {
+            LookAheadSegment& current = look_ahead_at(i);
+            LookAheadSegment& next = look_ahead_at(i + 1);
+
+            T v {std::min(current.v_junction, look_ahead_velocity(next.v_exit, next.a_target, next.length))};
+
+            if (v <= current.v_exit)
+                break;
+
+            current.v_exit = v;
+        }
+    }
+
+    void emit_look_ahead() {
+        LookAheadSegment& segment = look_ahead_at(0);
+
+        // Forward pass, the exit velocity must be reachable from the entry velocity.
+        T v_exit {std::min(segment.v_exit, look_ahead_velocity(v_enter, segment.a_target, segment.length))};
+
+        v_enter = plan_segment(segment, v_exit);
+
+        look_ahead_first = (look_ahead_first + 1) % look_ahead.size();
+        look_ahead_size--;
+    }
+
+    /**
+     * Plan the acceleration, coast and deceleration phase of a segment from v_enter to v_1 and return
+     * the exit velocity. The phases are rounded up to whole samples, which keeps the acceleration 
+     * within its limit, and a velocity is solved from the distance so the segment ends at its end point.
+     * In order of preference that is the peak velocity, with the first phase absorbing its change, the 
+     * velocity between two phases which replace the straight transition to v_1, or the exit velocity 
+     * of a single phase which ends below v_1. A segment which takes only a few samples can fit none of
+     * these, its velocities are kept within the limit and the remaining distance is carried into the
+     * next segment.
+     */
+    T plan_segment(const LookAheadSegment& segment, T v_1) {
+        const T c {segment.a_target / accel_peak_ratio};
+        const T half {static_cast<T>(0.5)};
+        const T p_start {-look_ahead_error};
+        const T length {segment.length + look_ahead_error};
+        const T v_0 {v_enter};
+
+        if (length <= 0) {
+            look_ahead_error = length;
+            return v_0;
+        }
+
+        auto samples = [this](T t) {
+            return std::max(0, static_cast<int>(std::ceil(t * hz - T(1e-6))));
+        };
+
+        // Velocity change of a phase within the acceleration limit, with a margin for the rounding of the solvers.
+        auto within_limit = [&](T v_delta, int n) {
+            return std::fabs(v_delta) <= c * n * dt * (1 + T(1e-9)) + T(1e-12);
+        };
+
+        int n_acc, n_coast, n_dec;
+        T v_p;
+
+        auto set_phases = [&](int acc, int coast, int dec, T v) {
+            n_acc = acc;
+            n_coast = coast;
+            n_dec = dec;
+            v_p = v;
+        };
+
+        // Velocities without rounding, the peak velocity is at least the entry and exit velocity.
+        T v_peak {std::min(segment.v_target, std::sqrt(c * length + half * (v_0 * v_0 + v_1 * v_1)))};
+        v_peak = std::max({v_peak, v_0, v_1});
+        T t_coast {std::max(T(0), (length - half * (2 * v_peak * v_peak - v_0 * v_0 - v_1 * v_1) / c) / v_peak)};
+
+        set_phases(std::max(samples((v_peak - v_0) / c), 1), samples(t_coast), samples((v_peak - v_1) / c), v_peak);
+
+        // The peak velocity for the rounded phases, without deceleration phase it is the exit velocity.
+        T t_acc {n_acc * dt};
+        T t_dec {n_dec * dt};
+        t_coast = n_coast * dt;
+
+        T v_solved {n_dec > 0 ? (length - half * (v_0 * t_acc + v_1 * t_dec)) / (half * (t_acc + t_dec) + t_coast)
+                              : (length - half * v_0 * t_acc) / (half * t_acc + t_coast)};
+        T v_low {std::max({T(0), v_0 - c * t_acc, n_dec > 0 ? v_1 - c * t_dec : T(0)})};
+        T v_high {std::min({segment.v_target, v_0 + c * t_acc, n_dec > 0 ? v_1 + c * t_dec : v_1})};
+
+        bool exact {v_solved >= v_low && v_solved <= v_high};
+        v_p = std::min(std::max(v_solved, v_low), v_high);
+
+        // Two phases to v_1 over the fewest samples around the straight transition for which both 
+        // respect the limit. The velocity between them is offset from the straight line by e, each 
+        // phase takes the samples it needs for its share of the offset.
+        int n_straight {v_0 + v_1 > 0 ? samples(2 * length / (v_0 + v_1)) : 0};
+
+        for (int n_total = std::max(2, n_straight - 8); !exact && n_straight > 0 && n_total <= n_straight + 8; n_total++) {
+            const T slope {(v_1 - v_0) / (n_total * dt)};
+            const T e {v_0 + v_1 - 2 * length / (n_total * dt)};
+            const T s {e >= 0 ? slope : -slope};
+
+            if (std::fabs(slope) >= c)
+                continue;
+
+            int n_0 {std::max(1, samples(std::fabs(e) / (c + s)))};
+            int n_1 {std::max(1, samples(std::fabs(e) / (c - s)))};
+            T v_between {v_0 + slope * n_0 * dt - e};
+
+            if (n_0 + n_1 <= n_total && v_between >= 0 && v_between <= segment.v_target
+                && within_limit(v_between - v_0, n_0) && within_limit(v_between - v_1, n_total - n_0)) {
+                set_phases(n_0, 0, n_total - n_0, v_between);
+                exact = true;
+            }
+        }
+
+        // A single phase which ends below v_1, the next segment is planned from the lower velocity.
+        if (!exact && n_straight > 0) {
+            T v_end {2 * length / (n_straight * dt) - v_0};
+
+            if (v_end >= 0 && v_end <= v_1 && within_limit(v_end - v_0, n_straight)) {
+                set_phases(n_straight, 0, 0, v_end);
+                exact = true;
+            }
+        }
+
+        // Otherwise the straight transition over the nearest amount of samples carries the least distance.
+        int n_nearest {v_0 + v_1 > 0 ? std::max(1, static_cast<int>(std::round(2 * length / ((v_0 + v_1) * dt)))) : 0};
+
+        if (!exact && n_nearest > 0 && within_limit(v_1 - v_0, n_nearest))
+            set_phases(n_nearest, 0, 0, v_1);
+
+        // Without deceleration phase the peak velocity is the exit velocity.
+        const T v_x {n_dec > 0 ? v_1 : v_p};
+
+        t_acc = n_acc * dt;
+        t_coast = n_coast * dt;
+        t_dec = n_dec * dt;
+
+        T p_acc {half * (v_0 + v_p) * t_acc};
+        T p_coast {v_p * t_coast};
+
+        MOTION_STATISTICS(this->statistics.record_look_ahead(segment.length));
+
+        look_ahead_error = exact ? 0 : length - p_acc - p_coast - half * (v_p + v_x) * t_dec;
+        MOTION_STATISTICS(this->statistics.record_error(look_ahead_error));
+
+        P::velocity_change(current_motion, v_0, v_p, t_acc);
+        update_motion(n_acc, segment.unit_vector, v_p, p_start, false, segment.start);
+
+        if (n_coast > 0)
+            update_motion(n_coast, segment.unit_vector, v_p, p_start + p_acc, true, segment.start);
+
+        if (n_dec > 0) {
+            P::velocity_change(current_motion, v_p, v_x, t_dec);
+            update_motion(n_dec, segment.unit_vector, v_p, p_start + p_acc + p_coast, false, segment.start);
+        }
+
+        return v_x;
+    }
+
+    /**
+     * Calculate the geometry and deceleration phase of the motion between p_0 and p_1, with p_2 
+     * defining the corner at p_1. The polynomial is only used as scratch space.
+     */
+    SegmentGeometry segment_geometry(Point<T, N> p_0, Point<T, N> p_1, Point<T, N> p_2, Polynomial<T>& scratch) const {
+        SegmentGeometry segment;
 
-    void plan_motion(){
         // Calculate delta's of axis.
-        auto m = ml::min(this->mp_buffer[1].setpoint, 
-                         this->mp_buffer[0].setpoint);
-        auto delta_unit {ml::unit_vector(m)};
-        auto carthesian_delta {ml::norm(m)};
+        auto m = ml::min_expr(p_1.setpoint, p_0.setpoint);
+        segment.delta_unit = ml::unit_vector(m);
+        segment.carthesian_delta = ml::norm(m);
 
         // Check for second motion entry.
-        if (carthesian_delta < 1e-9)
+        if (segment.carthesian_delta < T(1e-9))
+            return segment;
+
+        T ratio {ml::angle_ratio(p_0.setpoint, p_1.setpoint, p_2.setpoint)};
+
+        segment.v_exit = p_1.velocity * ratio;          // Velocity at end of trajectory (or final velocity).
+        segment.v_target = p_1.velocity;                // Velocity which the planner will try to reach.
+        segment.a_target = p_1.acceleration;            // Accelerataion which the planner will try to reach.
+
+        // Calculate the time and distance required to reach the exit velocity.
+        segment.t_dec = calc_accel_time(scratch, segment.v_exit - segment.v_target, segment.a_target);
+        segment.p_dec = std::fabs(calc_accel_position(scratch, segment.v_target, segment.v_exit, segment.t_dec));
+
+        return segment;
+    }
+
+    /**
+     * Replace the exit velocity of a segment by a final velocity, with the deceleration phase to it.
+     */
+    void final_velocity(SegmentGeometry& segment, T v_final, Polynomial<T>& scratch) const {
+        if (segment.carthesian_delta < T(1e-9))
             return;
 
-        T ratio {ml::angle_ratio(this->mp_buffer[0].setpoint, 
-                                 this->mp_buffer[1].setpoint, 
-                                 this->mp_buffer[2].setpoint)};
-        
-        T v_exit {this->mp_buffer[1].velocity * ratio};                         // Velocity at end of trajectory (or final velocity).
-        T v_target {this->mp_buffer[1].velocity};              // Velocity which the planner will try to reach.
-        T a_target {this->mp_buffer[1].acceleration};              // Accelerataion which the planner will try to reach.
-        
-        T v_delta {v_exit - v_enter};               // Delta velocity of the enter and exit velocities.
-        T v_delta_target {v_target - v_enter};      // Delta velocity for acceleration phase.
-        T v_delta_exit {v_exit - v_target};         // Delta velocity for deceleration phase.
+        segment.v_exit = v_final;
+        segment.t_dec = calc_accel_time(scratch, segment.v_exit - segment.v_target, segment.a_target);
+        segment.p_dec = std::fabs(calc_accel_position(scratch, segment.v_target, segment.v_exit, segment.t_dec));
+    }
+
+    void plan_motion(){
+        plan_motion(segment_geometry(this->mp_buffer[0], this->mp_buffer[1], this->mp_buffer[2], current_motion));
+    }
+
+    void plan_motion(SegmentGeometry segment){
+        // Check for second motion entry.
+        if (segment.carthesian_delta < T(1e-9))
+            return;
+
+        if (blend_tolerance > 0)
+            segment.v_exit = 0;
+
+        if (jerk_limit > 0 || blend_tolerance > 0) {
+            jerk_limited_motion(segment.carthesian_delta, segment.v_target, segment.a_target, segment.v_exit, segment.delta_unit, next_length());
+            v_enter = segment.v_exit;
+            return;
+        }
+
+        T& v_exit {segment.v_exit};
+        T& v_target {segment.v_target};
         
         // Calculate the time and distance required to reach target velocities.
-        T t_acc {this->calc_accel_time (v_delta_target, a_target)};
+        T t_acc {this->calc_accel_time (v_target - v_enter, segment.a_target)};
         T p_acc {this->calc_accel_position (v_enter, v_target, t_acc)};
 
-        T t_dec {this->calc_accel_time (v_delta_exit, a_target)};
-        T p_dec {fabs(this->calc_accel_position (v_target, v_exit, t_dec))};
-
         // Determine if the first and second acceleration event in the motion is bigger than the total distance.
         // If its true, coasting motion is calculated, if false, transition motion id calculated.
-        if ((carthesian_delta < 1) or ((p_acc + p_dec) > carthesian_delta))
+        if ((segment.carthesian_delta < 1) or ((p_acc + segment.p_dec) > segment.carthesian_delta))
             // Transition motion calculates two motions and "transitions" to a velocity/position.
-            transition(carthesian_delta, v_enter, v_target, a_target, delta_unit, v_exit, p_acc, p_dec);
+            transition(segment.carthesian_delta, v_enter, v_target, segment.a_target, segment.delta_unit, v_exit, p_acc, segment.p_dec);
         
         else 
             // Motion will calculate three motions from v_enter, to v_target, to v_exit.
-            motion(v_enter, v_target, v_exit, carthesian_delta, p_acc, p_dec, t_acc, t_dec, delta_unit);
+            motion(v_enter, v_target, v_exit, segment.carthesian_delta, p_acc, segment.p_dec, t_acc, segment.t_dec, segment.delta_unit);
 
         v_enter = v_exit;
     }  
 
     void plan_motion(T& v_final){
         // Calculate delta's of axis.
-        auto m = ml::min(this->mp_buffer[1].setpoint, 
+        auto m = ml::min_expr(this->mp_buffer[1].setpoint, 
                          this->mp_buffer[0].setpoint);
         auto delta_unit {ml::unit_vector(m)};
         auto carthesian_delta {ml::norm(m)};
 
         // Check for second motion entry.
-        if (carthesian_delta  < 1e-9)
+        if (carthesian_delta  < T(1e-9))
             return;
 
-        T ratio {ml::angle_ratio(this->mp_buffer[0].setpoint, 
-                                 this->mp_buffer[1].setpoint, 
-                                 this->mp_buffer[2].setpoint)};
-        
         T v_exit {v_final};                         // Velocity at end of trajectory (or final velocity).
         T v_target {this->mp_buffer[1].velocity};              // Velocity which the planner will try to reach.
         T a_target {this->mp_buffer[1].acceleration};              // Accelerataion which the planner will try to reach.
+
+        if (blend_tolerance > 0)
+            v_exit = 0;
+
+        if (jerk_limit > 0 || blend_tolerance > 0) {
+            jerk_limited_motion(carthesian_delta, v_target, a_target, v_exit, delta_unit, next_length());
+            v_enter = v_exit;
+            return;
+        }
         
-        T v_delta {v_exit - v_enter};               // Delta velocity of the enter and exit velocities.
         T v_delta_target {v_target - v_enter};      // Delta velocity for acceleration phase.
         T v_delta_exit {v_exit - v_target};         // Delta velocity for deceleration phase.
         
@@ -140,7 +652,7 @@ private:
         T p_acc {this->calc_accel_position(v_enter, v_target, t_acc)};
 
         T t_dec {this->calc_accel_time(v_delta_exit, a_target)};
-        T p_dec {fabs(this->calc_accel_position(v_target, v_exit, t_dec))};
+        T p_dec {std::fabs(this->calc_accel_position(v_target, v_exit, t_dec))};
 
         // Determine if the first and second acceleration event in the motion is bigger than the total distance.
         // If its true, coasting motion is calculated, if false, transition motion id calculated.
@@ -164,54 +676,64 @@ private:
     * @return Time required to change velocity and position that is reached.
     */
     T calc_accel_time(const T& v_delta, const T& a_target){
-        current_motion.calc_constants(v_delta, 1.0);
+        return calc_accel_time(current_motion, v_delta, a_target);
+    }
+
+    T calc_accel_time(Polynomial<T>& poly, const T& v_delta, const T& a_target) const {
+        P::velocity_change(poly, T(0), v_delta, T(1));
 
         // Calculate the time in respect to the discrete timing.
         // This means that the time should be rounded so an integral number of samples can be calculated from is.
-        return static_cast<T>(trunc(fabs(current_motion.polynomial_a(0.5) / a_target) * hz) * dt);
+        return static_cast<T>(std::trunc(std::fabs(poly.polynomial_a(0.5) / a_target) * hz) * dt);
     }
 
     T calc_accel_position (const T& v_enter, const T& v_target, const T& t) {
-        current_motion.calc_constants_v(v_enter, v_target, t);
-        return current_motion.polynomial_p(t);
+        return calc_accel_position(current_motion, v_enter, v_target, t);
+    }
+
+    T calc_accel_position (Polynomial<T>& poly, const T& v_enter, const T& v_target, const T& t) const {
+        P::velocity_change(poly, v_enter, v_target, t);
+        return poly.polynomial_p(t);
     }
 
     inline void transition (const T& carthesian_delta, const T& v_enter, T& v_target, const T& a_target, std::array<T, N>& delta_unit, T& v_exit, T& p_acc, T& p_dec){
+        MOTION_STATISTICS(this->statistics.record_transition(carthesian_delta));
+
         T t {1};
         T p_target_ratio {p_acc / (p_acc + p_dec)};
         
         // First calculate the ratio between position
 
-        if ((v_exit / v_target) < 0.05) {
-            current_motion.calc_constants_v(v_enter, v_target, v_exit, t * p_target_ratio, t);
+        if ((v_exit / v_target) < T(0.05)) {
+            P::velocity_change(current_motion, v_enter, v_target, v_exit, t * p_target_ratio, t);
             T ratio {carthesian_delta / current_motion.polynomial_p(t)};
 
             t *= ratio;
 
             // Now calculate the ratio between acceleration.
-            current_motion.calc_constants_v(v_enter, v_target, v_exit, t * p_target_ratio, t);
-            T a {current_motion.polynomial_a(t * p_target_ratio * 0.5)};
-            ratio = ml::fpow((a_target / a), 0.5);
+            P::velocity_change(current_motion, v_enter, v_target, v_exit, t * p_target_ratio, t);
+            T a {current_motion.polynomial_a(t * p_target_ratio * T(0.5))};
+            ratio = ml::sqrt(a_target / a);
 
             t /= ratio;
             v_target *= ratio;
             v_exit *= ratio;
 
-            current_motion.calc_constants_v(v_enter, v_target, v_exit, t * p_target_ratio, t);
+            P::velocity_change(current_motion, v_enter, v_target, v_exit, t * p_target_ratio, t);
 
             error = current_motion.polynomial_p(t) - carthesian_delta;
 
         } 
         else {
-            t = calc_accel_time((v_enter - v_exit), a_target);
-            current_motion.calc_constants_v(v_enter, v_exit, t);
-            t *= fabs((carthesian_delta - error) / current_motion.polynomial_p(t));
-
-            current_motion.calc_constants_v(v_enter, v_exit, t);
+            // The time is scaled to the distance below, it only has to be non-zero for equal velocities.
+            t = std::max(calc_accel_time((v_enter - v_exit), a_target), dt);
+            P::velocity_change(current_motion, v_enter, v_exit, t);
 
-            v_exit *= (carthesian_delta / current_motion.polynomial_p(t));
+            // The distance is met by the time alone, the velocity of the transition stays between v_enter
+            // and v_exit. A transition shorter than a sample takes one sample and carries the error.
+            t = std::max(t * std::fabs((carthesian_delta - error) / current_motion.polynomial_p(t)), dt);
 
-            current_motion.calc_constants_v(v_enter, v_exit, t);
+            P::velocity_change(current_motion, v_enter, v_exit, t);
 
             error = current_motion.polynomial_p(t) - carthesian_delta;
         }
@@ -223,13 +745,17 @@ private:
             {},
             false
         );
+
+        MOTION_STATISTICS(this->statistics.record_error(error));
     }
 
     inline void motion (const T& v_enter, const T& v_target, const T& v_exit, 
                  const T& p_delta_carthesian, const T& p_acc, const T& p_dec, 
                  const T& t_acc, const T& t_dec, const std::array<T, N>& delta_unit) {
+        MOTION_STATISTICS(this->statistics.record_motion(p_delta_carthesian));
+
         // Calculate the accelerating phase
-        current_motion.calc_constants_v(v_enter, v_target, t_acc);
+        P::velocity_change(current_motion, v_enter, v_target, t_acc);
 
         update_motion (
             static_cast<int> (t_acc * this->hz),
@@ -241,9 +767,10 @@ private:
 
         // Calculate the coasting phase
         // This formula is to make sure that timing requirements are met
-        T t {static_cast<T>(trunc(fabs((p_delta_carthesian - p_dec - p_acc - error) / v_target) * hz) * (dt))};
+        T t {static_cast<T>(std::trunc(std::fabs((p_delta_carthesian - p_dec - p_acc - error) / v_target) * hz) * (dt))};
         T p_coast {t * v_target}; 
         error = p_delta_carthesian - p_acc - p_dec - p_coast;
+        MOTION_STATISTICS(this->statistics.record_error(error));
 
         update_motion (
             static_cast<int> (t * this->hz),
@@ -254,7 +781,7 @@ private:
         );
 
         // Calculate deceleration phase
-        current_motion.calc_constants_v(v_target, v_exit, t_dec);
+        P::velocity_change(current_motion, v_target, v_exit, t_dec);
 
         update_motion (
             static_cast<int> (t_dec * this->hz),
@@ -265,16 +792,295 @@ private:
         );
     }
 
+    /**
+     * Length of the segment after the one being planned, from the last two points in the buffer.
+     */
+    T next_length() const {
+        return ml::norm(ml::min_expr(this->mp_buffer[2].setpoint, this->mp_buffer[1].setpoint));
+    }
+
+    /**
+     * Solver of the phases of a segment with the acceleration and the jerk limit.
+     */
+    PhaseSolver<T, P, ml::math> phase_solver(T a_target) const {
+        return {a_target, jerk_limit, hz};
+    }
+
+    /**
+     * Shortest time of a velocity change which respects the acceleration and the jerk limit.
+     * Without a jerk limit only the acceleration is respected.
+     */
+    T transition_time(T v_delta, T a_target) const {
+        return phase_solver(a_target).transition_time(v_delta);
+    }
+
+    T transition_distance(T v_0, T v_1, T a_target) const {
+        return T(0.5) * (v_0 + v_1) * transition_time(v_1 - v_0, a_target);
+    }
+
+    /**
+     * Highest velocity reachable from v over a distance, constrained by acceleration and jerk.
+     */
+    T reachable_velocity(T v, T a_target, T distance, T jerk) const {
+        if (distance <= 0)
+            return v;
+
+        T v_1 {reachable_velocity(v, a_target, distance)};
+        if (jerk <= 0 || accel_peak_ratio * (v_1 - v) / a_target >= std::sqrt(jerk_peak_ratio * (v_1 - v) / jerk))
+            return v_1;
+
+        // Jerk limited, with u = sqrt(v_1 - v): u^3 + 2 v u = 2 distance / sqrt(k_j). Solved with
+        // Cardano's formula, a Newton step restores the precision lost in the cancellation.
+        T p {2 * v};
+        T q {2 * distance / std::sqrt(jerk_peak_ratio / jerk)};
+        T r {std::sqrt(q * q / 4 + p * p * p / 27)};
+        T u {std::cbrt(q / 2 + r) + std::cbrt(q / 2 - r)};
+        u -= (u * u * u + p * u - q) / (3 * u * u + p);
+
+        return v + u * u;
+    }
+
+    /**
+     * Peak velocity between low and high at which accelerating from v_0 and decelerating to v_1
+     * takes the complete distance. The acceleration limited solution is exact when neither phase 
+     * is jerk limited, otherwise the bracket is narrowed with the Illinois method.
+     */
+    T peak_velocity(T v_0, T v_1, T low, T high, T a_target, T distance) const {
+        auto residual = [&](T v) {
+            return transition_distance(v_0, v, a_target) + transition_distance(v, v_1, a_target) - distance;
+        };
+
+        // Both phases acceleration limited: k_a * (v^2 - (v_0^2 + v_1^2) / 2) = distance.
+        T v {std::sqrt(distance * a_target / accel_peak_ratio + T(0.5) * (v_0 * v_0 + v_1 * v_1))};
+        T jerk_limited_below {jerk_limit > 0 ? jerk_peak_ratio * a_target * a_target / (accel_peak_ratio * accel_peak_ratio * jerk_limit) : 0};
+        if (v >= low && v <= high && v - v_0 >= jerk_limited_below && v - v_1 >= jerk_limited_below)
+            return v;
+
+        return bracket_root(residual, low, high);
+    }
+
+    /**
+     * Root of f between low and high with f(low) <= 0 <= f(high), found with the Illinois method.
+     * The amount of iterations is bounded, it typically converges in less than ten.
+     */
+    template <typename F>
+    static T bracket_root(F f, T low, T high) {
+        T f_low {f(low)};
+        T f_high {f(high)};
+        int side {0};
+        T v {low};
+
+        for (int i = 0; i < 64 && high - low > std::numeric_limits<T>::epsilon() * high; i++) {
+            v = (low * f_high - high * f_low) / (f_high - f_low);
+            T f_v {f(v)};
+
+            if ((f_v < 0) == (f_low < 0)) {
+                low = v;
+                f_low = f_v;
+                if (side == -1)
+                    f_high *= T(0.5);
+                side = -1;
+            }
+            else {
+                high = v;
+                f_high = f_v;
+                if (side == 1)
+                    f_low *= T(0.5);
+                side = 1;
+            }
+
+            if (f_v == 0)
+                break;
+        }
+
+        return v;
+    }
+
+    /**
+     * Jerk limited segment, see set_jerk_limit(). The segment accelerates from v_enter to a peak 
+     * velocity, coasts and decelerates to v_exit. The exit velocity is lowered when it cannot be 
+     * reached within the segment, or when the next segment could not stop from it.
+     * 
+     * The phases are rounded up to whole samples, after which the peak velocity is solved from the
+     * distance, so the segment ends exactly at its end point. A phase which exceeds the limits with 
+     * the new peak velocity is lengthened and the peak velocity is solved again.
+     */
+    void jerk_limited_motion(T length, T v_target, T a_target, T& v_exit, const std::array<T, N>& delta_unit, T next_length) {
+        v_exit = std::min({v_exit, v_target, reachable_velocity(0, a_target, next_length, jerk_limit)});
+
+        if (v_exit > v_enter && transition_distance(v_enter, v_exit, a_target) > length)
+            v_exit = std::min(v_exit, reachable_velocity(v_enter, a_target, length, jerk_limit));
+
+        T v_p {v_target};
+        T t_coast {0};
+        T p_max {transition_distance(v_enter, v_target, a_target) + transition_distance(v_target, v_exit, a_target)};
+        T p_stop {transition_distance(v_enter, 0, a_target)};
+
+        if (p_max <= length) {
+            t_coast = (length - p_max) / v_target;
+        }
+        else if (v_exit < v_enter && transition_distance(v_enter, v_exit, a_target) >= length) {
+            // A single deceleration phase. When jerk limited, a lower exit velocity can take less distance.
+            if (p_stop < length)
+                v_exit = bracket_root([&](T v) { return transition_distance(v_enter, v, a_target) - length; }, 0, v_exit);
+            else
+                v_exit = 0;
+
+            v_p = v_enter;
+        }
+        else {
+            // Entering above the target velocity, the peak velocity is between v_exit and v_target.
+            T low {v_enter <= v_target ? std::max(v_enter, v_exit) : v_exit};
+            v_p = peak_velocity(v_enter, v_exit, low, v_target, a_target, length);
+        }
+
+        // Rounding errors of the solvers must not create phases.
+        T tolerance {std::max(v_p, T(1)) * T(1e-9)};
+        if (std::fabs(v_p - v_enter) < tolerance)
+            v_p = v_enter;
+        if (std::fabs(v_p - v_exit) < tolerance)
+            v_p = v_exit;
+
+        std::array<int, 3> n {};
+        phase_solver(a_target).round_phases(length, v_enter, v_p, v_exit, t_coast, n);
+
+        int n_acc {n[0]}, n_coast {n[1]}, n_dec {n[2]};
+        T t_acc {n_acc * dt};
+        T t_coast_n {n_coast * dt};
+        T t_dec {n_dec * dt};
+
+        MOTION_STATISTICS(n_coast > 0 ? this->statistics.record_motion(length) : this->statistics.record_transition(length));
+
+        T p_acc {T(0.5) * (v_enter + v_p) * t_acc};
+        T p_coast {v_p * t_coast_n};
+
+        P::velocity_change(current_motion, v_enter, v_p, t_acc);
+        blend_next = blend_tolerance > 0;
+        update_motion(n_acc, delta_unit, v_p, 0, false);
+
+        if (n_coast > 0)
+            update_motion(n_coast, delta_unit, v_p, p_acc, true);
+
+        if (n_dec > 0) {
+            P::velocity_change(current_motion, v_p, v_exit, t_dec);
+            update_motion(n_dec, delta_unit, v_p, p_acc + p_coast, false);
+        }
+    }
+
+    /**
+     * Largest overlap of the last motion of the previous segment with the first motion of the next
+     * segment for which the superposed path stays within the blend tolerance of both segments, 
+     * see set_blend_tolerance(). The deviation grows with the overlap, which is found by bisection.
+     * The windows of the bisection overlap, so the distance along each motion is evaluated once per 
+     * sample and kept in blend_tail and blend_head.
+     */
+    int blend_samples(const MotionObject<T, N>& prev, const MotionObject<T, N>& next) {
+        if (prev.n == 0 || prev.is_coast)
+            return 0;
+
+        const std::array<T, N>& corner {next.prev_setpoint};
+
+        const T tolerance_2 {blend_tolerance * blend_tolerance};
+
+        // Distance along motion m at sample k, as evaluated by MotionObject::get_state().
+        auto distance = [](const MotionObject<T, N>& m, int k) {
+            T p {}, v {}, a {};
+
+            if (m.is_coast)
+                p = m.p_0 + m.v_target * (m.dt * k);
+            else
+                m.polynomial_pva(m.dt * k, p, v, a);
+
+            return p;
+        };
+
+        // blend_tail[k] holds sample prev.n - 1 - k of the previous motion, blend_head[j] sample j of the next.
+        blend_tail.clear();
+        blend_head.clear();
+
+        auto within_tolerance = [&](int w) {
+            while (static_cast<int>(blend_tail.size()) < w) {
+                blend_tail.push_back(distance(prev, prev.n - 1 - static_cast<int>(blend_tail.size())));
+                blend_head.push_back(distance(next, static_cast<int>(blend_head.size())));
+            }
+
+            T d_corner {w > 0 ? std::numeric_limits<T>::max() : 0};
+
+            for (int j = 0; j < w; j++) {
+                const T p_a {blend_tail[w - 1 - j]};
+                const T p_b {blend_head[j]};
+
+                // Offset of the superposed position from the corner, projected on the rays 
+                // of the previous segment (backwards) and the next segment.
+                std::array<T, N> q;
+                T s_prev {0}, s_next {0};
+                for (size_t i = 0; i < N; i++) {
+                    q[i] = ((p_a * prev.unit_vector[i]) + prev.prev_setpoint[i]) 
+                         + ((p_b * next.unit_vector[i]) + next.prev_setpoint[i]) - 2 * corner[i];
+                    s_prev -= q[i] * prev.unit_vector[i];
+                    s_next += q[i] * next.unit_vector[i];
+                }
+
+                s_prev = std::max(s_prev, T(0));
+                s_next = std::max(s_next, T(0));
+
+                T d_prev {0}, d_next {0};
+                for (size_t i = 0; i < N; i++) {
+                    d_prev += (q[i] + s_prev * prev.unit_vector[i]) * (q[i] + s_prev * prev.unit_vector[i]);
+                    d_next += (q[i] - s_next * next.unit_vector[i]) * (q[i] - s_next * next.unit_vector[i]);
+                }
+
+                if (std::min(d_prev, d_next) > tolerance_2)
+                    return false;
+
+                d_corner = std::min(d_corner, ml::dot(q, q));
+            }
+
+            // The path must also pass the corner within the tolerance, which limits the overlap 
+            // of segments which reverse along the same line.
+            return d_corner <= tolerance_2;
+        };
+
+        // Both motions keep a sample outside the overlap, so a sampler switches once per motion.
+        int low {0};
+        int high {std::min(prev.n, next.n) - 1};
+
+        while (low < high) {
+            int w {(low + high + 1) / 2};
+
+            if (within_tolerance(w))
+                low = w;
+            else
+                high = w - 1;
+        }
+
+        return low;
+    }
+
     void update_motion (int n, const std::array<T, N>& unit_vec, T velocity, T p_0, bool is_coast) {
+        update_motion(n, unit_vec, velocity, p_0, is_coast, this->mp_buffer[0].setpoint);
+    }
+
+    void update_motion (int n, const std::array<T, N>& unit_vec, T velocity, T p_0, bool is_coast, const std::array<T, N>& start) {
         current_motion.n = n;
         current_motion.dt = dt;
         current_motion.unit_vector = unit_vec;
         current_motion.v_target = velocity;
         current_motion.is_coast = is_coast;
         current_motion.p_0 = p_0;
-        current_motion.prev_setpoint = this->mp_buffer[0].setpoint;
+        current_motion.prev_setpoint = start;
+
+        if (blend_tolerance > 0) {
+            if (blend_next)
+                current_motion.blend = blend_samples(previous_phase, current_motion);
+
+            blend_next = false;
+            previous_phase = current_motion;
+        }
         
-        this->append_motion(current_motion);
+        // The plan calls check that the move fits before planning, so this is not expected to fail.
+        if (!this->append_motion(current_motion))
+            rejected = true;
 
         current_motion.reset();
     }
@@ -0,0 +1,299 @@
+/**
+ * Copyright (c) 2020 Bas Brussen
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.                                                                         
+ * 
+ * 
+ * @file MultiRateMotion.hpp
+ *
+ * @brief Motion which is planned once and sampled at multiple rates.
+ *
+ * @author Bas Brussen
+ * Contact: b.brussen@outlook.com
+ *
+ */
+
+#ifndef MultiRateMotion_hpp
+#define MultiRateMotion_hpp
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "MotionPlanner.hpp"
+
+/**
+ * The motions are polynomials in continuous time, the planning rate only sets the grid of their 
+ * durations. Every sampler evaluates the planned trajectory at its own rate and phase, e.g. a 1 kHz 
+ * supervisor and a 20 kHz current loop share one plan. The queued moves are evaluated directly, 
+ * a move is removed from the queue when all samplers passed it. A motion without samples holds 
+ * its start state during one planning sample, as it does for BasicMotion. Blended corners are 
+ * superposed as they are by BasicMotion.
+ * 
+ * A sampler which reaches the end of the planned trajectory holds the end state and its clock
+ * stops until the next move is queued. A move which is queued after a sampler returned a sample 
+ * beyond its start, after a hold or inside the overlap of a blended corner, is not blended for that
+ * sampler: the previous move is finished and the move starts at the next sample of the sampler, 
+ * as it does for BasicMotion.
+ * 
+ * All samplers are used from one thread. With SpscQueue planning may run on another thread.
+ * 
+ * Template arguments:
+ * @param T     Type of the scalar.
+ * @param N     Number of dimensions.
+ * @param Q     Queue which stores the moves.
+ * @param B     Buffer policy, see MotionPlanner.
+ * @param P     Profile policy, see MotionPlanner.
+ */
+template <typename T, size_t N, typename Q = std::queue<MoveRecord<T, N>>, 
+          typename B = SetpointBuffer<T, N>, typename P = SmoothProfile<T>>
+class MultiRateMotion : public MotionPlanner<T, N, Q, B, P> {
+public:
+    /**
+     * @param hz    Planning rate, the durations of the motions are multiples of its period.
+     */
+    MultiRateMotion(int hz) : 
+        MotionPlanner<T, N, Q, B, P>(hz) {}
+
+    MultiRateMotion(int hz, std::array<T, N> p) : 
+        MotionPlanner<T, N, Q, B, P>(hz, p) {
+        initial.position = p;
+    }
+
+    /**
+     * Plan a motion, see BasicMotion::plan().
+     */
+    inline bool plan(std::array<T, N> pos) {
+        Point<T, N> p(pos);
+        return this->append_and_plan(p);
+    }
+
+    inline bool plan(std::array<T, N> pos, T vel, T acc) {
+        Point<T, N> p(pos, vel, acc);
+        return this->append_and_plan(p);
+    }
+
+    inline bool plan(std::array<T, N> pos, T vel, T acc, T v_final) {
+        Point<T, N> p(pos, vel, acc);
+        return this->append_and_plan(p, v_final);
+    }
+
+    /**
+     * Add a sampler. It starts at the first sample of the trajectory plus its phase.
+     * 
+     * @param hz        Sample rate of the sampler.
+     * @param phase     Time of the first sample in seconds, e.g. a fraction of the period. Not negative.
+     * @return Index of the sampler.
+     */
+    size_t add_sampler(int hz, T phase = 0) {
+        Sampler s;
+        s.step = static_cast<T>(this->hz) / hz;
+        s.offset = phase * this->hz;
+        s.motion = retired;
+
+        samplers.push_back(s);
+        return samplers.size() - 1;
+    }
+
+    size_t sampler_count() const {
+        return samplers.size();
+    }
+
+    /**
+     * Get the position, velocity and acceleration of all dimensions at the current sample of a sampler.
+     * After the last motion the final state is held.
+     * 
+     * @param sampler   Index of the sampler.
+     * @return MotionState<T, N> of position, velocity and acceleration.
+     */
+    MotionState<T, N> get_state_setpoint(size_t sampler) {
+        MotionState<T, N> state;
+        Sampler& s {samplers[sampler]};
+        const MoveRecord<T, N>* m {find_move(s)};
+        T k {planning_sample(s)};
+
+        s.last = k;
+        s.sampled = true;
+
+        if (!m)
+            return initial;
+
+        // Past the end of the move only occurs at the end of the trajectory, the end state is held.
+        int i {m->phase_at(static_cast<long long>(std::floor(k)))};
+        T local {std::min(std::max(k - m->phase_start(i), T(0)), static_cast<T>(m->n[i]))};
+        m->get_state_at(i, this->dt * local, state);
+
+        // In the overlap of a blended move the last motion of the previous move is superposed.
+        if (i == 0 && local < m->blend && s.motion > retired && s.motion != s.late) {
+            const MoveRecord<T, N>& previous {this->peek_move(s.motion - retired - 1)};
+            int j {previous.phases - 1};
+            MotionState<T, N> blended;
+
+            previous.get_state_at(j, this->dt * (k - previous.phase_start(j)), blended);
+            state.position = ml::add(state.position, ml::min_expr(blended.position, m->prev_setpoint));
+            state.velocity = ml::add(state.velocity, blended.velocity);
+            state.acceleration = ml::add(state.acceleration, blended.acceleration);
+        }
+
+        return state;
+    }
+
+    /**
+     * Advance a sampler to its next sample, see BasicMotion::increment_motion_sample().
+     * At or after the end of the trajectory the sampler is not advanced.
+     * 
+     * @param sampler   Index of the sampler.
+     * @return False when the sample was at or after the end of the trajectory.
+     */
+    bool increment_motion_sample(size_t sampler) {
+        bool in_progress {motion_in_progress(sampler)};
+
+        if (in_progress)
+            samplers[sampler].sample++;
+
+        retire();
+
+        return in_progress;
+    }
+
+    /**
+     * True while the current sample of a sampler is before the end of the planned trajectory.
+     */
+    bool motion_in_progress(size_t sampler) const {
+        size_t size {static_cast<size_t>(this->motion_queue_size())};
+
+        if (size == 0)
+            return false;
+
+        return planning_sample(samplers[sampler]) < this->peek_move(size - 1).end();
+    }
+
+    /**
+     * Time of the current sample of a sampler, counted from the first sample of the trajectory.
+     * 
+     * @return Time in seconds.
+     */
+    T sample_time(size_t sampler) const {
+        return planning_sample(samplers[sampler]) * this->dt;
+    }
+
+private:
+    static constexpr size_t none = std::numeric_limits<size_t>::max();
+
+    struct Sampler {
+        // Period and phase in planning samples.
+        T step {1};
+        T offset {0};
+        long long sample {0};
+        // Planning samples the trajectory is behind the clock of the sampler, see find_move().
+        T delay {0};
+        // Move which contains the current sample, counted from the first queued move.
+        size_t motion {0};
+        // Moves which are checked for a late arrival and the move which arrived late.
+        size_t checked {0};
+        size_t late {none};
+        // Time of the last returned sample in planning samples.
+        T last {0};
+        bool sampled {false};
+    };
+
+    /**
+     * Time of the current sample in planning samples. Equals the sample counter when 
+     * the sampler runs at the planning rate, which keeps the results equal to BasicMotion.
+     */
+    T planning_sample(const Sampler& s) const {
+        return s.offset + s.sample * s.step - s.delay;
+    }
+
+    /**
+     * Move which contains the current sample. Samples advance monotonically, so the move is 
+     * found by stepping forward from the previous move of the sampler. A late move is entered
+     * at the end of the previous move and the sampler is delayed by whole periods, so the 
+     * move starts within one period after its start.
+     */
+    const MoveRecord<T, N>* find_move(Sampler& s) {
+        size_t size {static_cast<size_t>(this->motion_queue_size())};
+
+        if (size == 0)
+            return nullptr;
+
+        check_late(s, size);
+
+        while (s.motion - retired + 1 < size) {
+            const MoveRecord<T, N>& next {this->peek_move(s.motion - retired + 1)};
+            bool late {s.motion + 1 == s.late};
+
+            if (planning_sample(s) < next.start + (late ? next.blend : 0))
+                break;
+
+            if (late) {
+                T behind {planning_sample(s) - next.start};
+                s.delay += behind - std::fmod(behind, s.step);
+            }
+
+            s.motion++;
+        }
+
+        return &this->peek_move(s.motion - retired);
+    }
+
+    /**
+     * A move is late for a sampler when the sampler returned a sample beyond its start before 
+     * it was queued. Only the first move queued since the last check can be late, the moves 
+     * after it start after its end.
+     */
+    void check_late(Sampler& s, size_t size) {
+        if (retired + size <= s.checked)
+            return;
+
+        size_t first {std::max(s.checked, retired)};
+        if (s.sampled && s.last > this->peek_move(first - retired).start)
+            s.late = first;
+
+        s.checked = retired + size;
+    }
+
+    /**
+     * Remove the moves which all samplers passed. The last move is kept to hold its end state,
+     * a move which overlaps the next move is kept until the overlap is passed.
+     */
+    void retire() {
+        while (this->motion_queue_size() > 1) {
+            const MoveRecord<T, N>& first {this->peek_move(0)};
+
+            // Samplers step into the next move first, a late move delays the sampler.
+            for (Sampler& s : samplers) {
+                find_move(s);
+                if (planning_sample(s) < first.end())
+                    return;
+            }
+
+            this->pop_move();
+            retired++;
+        }
+    }
+
+    std::vector<Sampler> samplers;
+    // Amount of moves removed from the queue, the index of the first queued move.
+    size_t retired {0};
+    // State before the first motion is planned.
+    MotionState<T, N> initial;
+};
+
+#endif
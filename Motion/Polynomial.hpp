@@ -31,11 +31,18 @@
 #ifndef Polynomial_hpp
 #define Polynomial_hpp
 
+#include <algorithm>
 #include <cmath>
+#include <array>
 
 template <typename T>
 struct Polynomial {
-    static constexpr T pol_p_c = 1.0 / 420.0;
+    static constexpr T pol_p_c = T(1) / T(420);
+
+    // Peak acceleration and peak jerk of a transition of calc_constants_v(v_s, v_f, t), relative to 
+    // (v_f - v_s) / t and (v_f - v_s) / t^2. The jerk peaks at t * (3 - sqrt(3)) / 6 with 10 / sqrt(3).
+    static constexpr T accel_peak_ratio = T(1.875);
+    static constexpr T jerk_peak_ratio = T(5.773502691896258);
 
     T c_3;
     T c_4;
@@ -44,10 +51,8 @@ struct Polynomial {
     T v_0;
     T p_0;
     
-    Polynomial() : 
-    c_3(1.), c_4(1.), c_5(1.), c_6(1.), v_0(0.), p_0(0.) {}
-
-    virtual ~Polynomial(){}
+    constexpr Polynomial() : 
+    c_3(1), c_4(1), c_5(1), c_6(1), v_0(0), p_0(0) {}
 
     /**
      * Formula to calculate the poylnomial constants.
@@ -55,13 +60,13 @@ struct Polynomial {
      * @param v_f   Final velocity of the polynomial
      * @param t     Time the polynomial should take for reaching final value.
      */
-    inline void calc_constants(T v_f, T t){
-        T v_v = v_f * 0.5;
+    constexpr void calc_constants(T v_f, T t){
+        T v_v = v_f * T(0.5);
 
-        c_3 = 2. * (32. * v_v - 11. * v_f) / (t * t * t);
-        c_4 = -3. * (64. * v_v - 27. * v_f) / (t * t * t * t);
-        c_5 = 3. * (64. * v_v - 30. * v_f) / (t * t * t * t * t);
-        c_6 = -32. * (2. * v_v - v_f) / (t * t * t * t * t * t);
+        c_3 = 2 * (32 * v_v - 11 * v_f) / (t * t * t);
+        c_4 = -3 * (64 * v_v - 27 * v_f) / (t * t * t * t);
+        c_5 = 3 * (64 * v_v - 30 * v_f) / (t * t * t * t * t);
+        c_6 = -32 * (2 * v_v - v_f) / (t * t * t * t * t * t);
     }
 
     /**
@@ -71,21 +76,19 @@ struct Polynomial {
      * @param v_f   Final velocity of the polynomial
      * @param t     Time the polynomial should take for reaching final value.
      */
-    inline void calc_constants_v(T v_s, T v_f, T t){
-        T v_h = v_f > v_s ? v_f : v_s;
-        T v_l = v_f < v_s ? v_f : v_s;
-
-        T v_v = (v_h - v_l) * 0.5;
+    constexpr void calc_constants_v(T v_s, T v_f, T t){
+        // Velocity at t / 2, which makes the acceleration symmetric with its peak at t / 2.
+        T v_v = (v_s + v_f) * T(0.5);
 
         v_0 = v_s;
 
         T v_d_0 = v_v - v_s;
         T v_d_1 = v_f - v_s;
 
-        c_3 = 2. * (32. * v_d_0 - 11. * v_d_1) / (t * t * t);
-        c_4 = -3. * (64. * v_d_0 - 27. * v_d_1) / (t * t * t * t);
-        c_5 = 3. * (64. * v_d_0 - 30. * v_d_1) / (t * t * t * t * t);
-        c_6 = -32. * (2. * v_d_0 - v_d_1) / (t * t * t * t * t * t);
+        c_3 = 2 * (32 * v_d_0 - 11 * v_d_1) / (t * t * t);
+        c_4 = -3 * (64 * v_d_0 - 27 * v_d_1) / (t * t * t * t);
+        c_5 = 3 * (64 * v_d_0 - 30 * v_d_1) / (t * t * t * t * t);
+        c_6 = -32 * (2 * v_d_0 - v_d_1) / (t * t * t * t * t * t);
     }
 
     /**
@@ -96,19 +99,19 @@ struct Polynomial {
      * @param v_f   Final velocity of the polynomial
      * @param t     Time the polynomial should take for reaching final value.
      */
-    inline void calc_constants_v(T v_s, T v_v, T v_f, T t){
+    constexpr void calc_constants_v(T v_s, T v_v, T v_f, T t){
         v_0 = v_s;
 
         T v_d_0 = v_v - v_s;
         T v_d_1 = v_f - v_s;
 
-        c_3 = 2. * (32. * v_d_0 - 11. * v_d_1) / (t * t * t);
-        c_4 = -3. * (64. * v_d_0 - 27. * v_d_1) / (t * t * t * t);
-        c_5 = 3. * (64. * v_d_0 - 30. * v_d_1) / (t * t * t * t * t);
-        c_6 = -32. * (2. * v_d_0 - v_d_1) / (t * t * t * t * t * t);
+        c_3 = 2 * (32 * v_d_0 - 11 * v_d_1) / (t * t * t);
+        c_4 = -3 * (64 * v_d_0 - 27 * v_d_1) / (t * t * t * t);
+        c_5 = 3 * (64 * v_d_0 - 30 * v_d_1) / (t * t * t * t * t);
+        c_6 = -32 * (2 * v_d_0 - v_d_1) / (t * t * t * t * t * t);
     }
 
-    inline void calc_constants_v(T v_s, T v_v, T v_f, T t_v, T t_f) {
+    constexpr void calc_constants_v(T v_s, T v_v, T v_f, T t_v, T t_f) {
         v_0 = v_s;
 
         T t_c = 1 / ((t_f - t_v) * (t_f - t_v) * (t_f - t_v));
@@ -141,7 +144,7 @@ struct Polynomial {
      * 
      * @param t     Time at which the position should be calculated.
      */
-    inline T polynomial_p(T t){
+    constexpr T polynomial_p(T t){
         return  pol_p_c * t * (105 * c_3 * (t * t * t) + 
                 2 * (42 * c_4 * (t * t * t * t) + 
                 5 * (6 * (c_6 * (t * t * t* t * t * t) + 7 * v_0) + 
@@ -153,7 +156,7 @@ struct Polynomial {
      * 
      * @param t     Time at which the velocity should be calculated.
      */
-    inline T polynomial_v(T t){
+    constexpr T polynomial_v(T t){
         return (t * t * t) * (t * (t * (c_6 * t + c_5) + c_4) + c_3) + v_0;
     } 
 
@@ -162,8 +165,311 @@ struct Polynomial {
      * 
      * @param t     Time at which the acceleration should be calculated.
      */
-    inline T polynomial_a(T t){
-        return (t * t) * (t * (6. * c_6 * (t * t) + 5. * c_5 * t + 4 * c_4) + 3. * c_3);
+    constexpr T polynomial_a(T t){
+        return (t * t) * (t * (6 * c_6 * (t * t) + 5 * c_5 * t + 4 * c_4) + 3 * c_3);
+    }
+
+    /**
+     * Return position, velocity and acceleration at once. The powers of t are shared 
+     * between the three polynomials, results are equal to the separate functions.
+     * 
+     * @param t     Time at which the state should be calculated.
+     * @param p     Position at t.
+     * @param v     Velocity at t.
+     * @param a     Acceleration at t.
+     */
+    constexpr void polynomial_pva(T t, T& p, T& v, T& a) const {
+        T t_2 = t * t;
+        T t_3 = t_2 * t;
+        T t_4 = t_3 * t;
+        T t_5 = t_4 * t;
+        T t_6 = t_5 * t;
+
+        p = pol_p_c * t * (105 * c_3 * t_3 + 
+            2 * (42 * c_4 * t_4 + 
+            5 * (6 * (c_6 * t_6 + 7 * v_0) + 
+            7 * c_5 * t_5))) + p_0;
+        v = t_3 * (t * (t * (c_6 * t + c_5) + c_4) + c_3) + v_0;
+        a = t_2 * (t * (6 * c_6 * t_2 + 5 * c_5 * t + 4 * c_4) + 3 * c_3);
+    }
+};
+
+/**
+ * Default profile policy of the planner, the shape of a velocity change. The planner sets the 
+ * constants of a polynomial with velocity_change() and derives the duration of a change from 
+ * the peak ratios. A profile covers the distance of the mean velocity times its duration, and 
+ * starts and ends without acceleration or jerk, as the sampled polynomials require.
+ * 
+ * Template arguments:
+ * @param T     Type of the scalar.
+ */
+template <typename T>
+struct SmoothProfile {
+    static constexpr T accel_peak_ratio = Polynomial<T>::accel_peak_ratio;
+    static constexpr T jerk_peak_ratio = Polynomial<T>::jerk_peak_ratio;
+
+    /**
+     * Change the velocity from v_s to v_f in time t.
+     */
+    static constexpr void velocity_change(Polynomial<T>& poly, T v_s, T v_f, T t) {
+        poly.calc_constants_v(v_s, v_f, t);
+    }
+
+    /**
+     * Change the velocity from v_s to v_f in time t, with velocity v_v at t / 2.
+     */
+    static constexpr void velocity_change(Polynomial<T>& poly, T v_s, T v_v, T v_f, T t) {
+        poly.calc_constants_v(v_s, v_v, v_f, t);
+    }
+
+    /**
+     * Change the velocity from v_s to v_f in time t_f, with velocity v_v at t_v.
+     */
+    static constexpr void velocity_change(Polynomial<T>& poly, T v_s, T v_v, T v_f, T t_v, T t_f) {
+        poly.calc_constants_v(v_s, v_v, v_f, t_v, t_f);
+    }
+};
+
+/**
+ * Phases of a segment which accelerates from v_enter to a peak velocity, coasts and decelerates 
+ * to v_exit within an acceleration and a jerk limit. The jerk limited planner solves its segments 
+ * with it (see MotionPlanner::set_jerk_limit()), StaticMove solves a move in a constant expression.
+ * 
+ * Template arguments:
+ * @param T     Type of the scalar.
+ * @param P     Profile policy with the peak ratios, see SmoothProfile.
+ * @param M     Functions sqrt and ceil, ml::math or ml::constant::math in constant expressions.
+ */
+template <typename T, typename P, typename M>
+struct PhaseSolver {
+    T a_target;
+    T jerk;     // Jerk limit, 0 limits the acceleration only.
+    int hz;
+
+    /**
+     * Shortest time of a velocity change which respects the acceleration and the jerk limit.
+     * The peak acceleration and jerk of a transition scale with v_delta / t and v_delta / t^2.
+     */
+    constexpr T transition_time(T v_delta) const {
+        v_delta = v_delta < 0 ? -v_delta : v_delta;
+        T t {P::accel_peak_ratio * v_delta / a_target};
+
+        if (jerk > 0)
+            t = std::max(t, M::sqrt(P::jerk_peak_ratio * v_delta / jerk));
+
+        return t;
+    }
+
+    /**
+     * Amount of samples of a phase, rounded up so the limits of the phase are respected.
+     */
+    constexpr int phase_samples(T v_delta) const {
+        return std::max(0, static_cast<int>(M::ceil(transition_time(v_delta) * hz - T(1e-6))));
+    }
+
+    /**
+     * Round the phases up to whole samples, after which the peak velocity is solved from the 
+     * distance, so the segment ends exactly at its end point. A phase which exceeds the limits 
+     * with the new peak velocity is lengthened and the peak velocity is solved again.
+     * 
+     * @param length    Length of the segment.
+     * @param v_enter   Entry velocity.
+     * @param v_p       Peak velocity of the segment in continuous time, receives the solved peak velocity.
+     * @param v_exit    Exit velocity, equals the peak velocity when the segment has no deceleration phase.
+     * @param t_coast   Coast time of the segment in continuous time.
+     * @param n         Receives the samples of the acceleration, coast and deceleration phase.
+     */
+    constexpr void round_phases(T length, T v_enter, T& v_p, T& v_exit, T t_coast, std::array<int, 3>& n) const {
+        // The accelerating phase absorbs the change of the peak velocity, so it takes at least one sample.
+        n[0] = std::max(1, phase_samples(v_p - v_enter));
+        n[1] = static_cast<int>(M::ceil(t_coast * hz - T(1e-6)));
+        n[2] = phase_samples(v_p - v_exit);
+
+        T dt {T(1) / hz};
+
+        for (int i = 0; i < 8; i++) {
+            T t_acc {n[0] * dt};
+            T t_coast_n {n[1] * dt};
+            T t_dec {n[2] * dt};
+
+            // The distance is linear in the peak velocity once the durations are fixed.
+            if (n[2] > 0)
+                v_p = (length - T(0.5) * (v_enter * t_acc + v_exit * t_dec)) / (T(0.5) * (t_acc + t_dec) + t_coast_n);
+            else
+                v_exit = v_p = (length - T(0.5) * v_enter * t_acc) / (T(0.5) * t_acc + t_coast_n);
+
+            int n_acc_min {phase_samples(v_p - v_enter)};
+            int n_dec_min {n[2] > 0 ? phase_samples(v_p - v_exit) : 0};
+
+            if (n[0] >= n_acc_min && n[2] >= n_dec_min)
+                break;
+
+            n[0] = std::max(n[0], n_acc_min);
+            n[2] = std::max(n[2], n_dec_min);
+        }
+    }
+};
+
+/**
+ * Forward difference table of a polynomial of degree D at equidistant samples.
+ * After anchoring, every step advances the value one sample in D additions.
+ */
+template <typename T, size_t D>
+struct ForwardDifference {
+    std::array<T, D + 1> d {};
+
+    /**
+     * Build the table from the polynomial coefficients.
+     * 
+     * @param m     Coefficients of t^0 ... t^D.
+     * @param t     Time of the first sample.
+     * @param dt    Time between samples.
+     */
+    void anchor(const std::array<T, D + 1>& m, T t, T dt) {
+        static const Table table {};
+        std::array<T, D + 1> b {};
+
+        // Taylor coefficients around t, scaled to the sample index k = (t' - t) / dt.
+        T h {1};
+        for (size_t j = 0; j <= D; j++) {
+            T t_p {1};
+            T sum {0};
+
+            for (size_t i = j; i <= D; i++) {
+                sum += m[i] * table.binomial[i][j] * t_p;
+                t_p *= t;
+            }
+
+            b[j] = sum * h;
+            h *= dt;
+        }
+
+        for (size_t j = 0; j <= D; j++) {
+            T sum {0};
+
+            for (size_t i = j; i <= D; i++)
+                sum += b[i] * table.delta[i][j];
+
+            d[j] = sum;
+        }
+    }
+
+    inline void step() {
+        for (size_t j = 0; j < D; j++)
+            d[j] += d[j + 1];
+    }
+
+    inline T value() const {
+        return d[0];
+    }
+
+private:
+    /**
+     * Binomial coefficients C(i, j) and the j-th forward difference of k^i at k = 0,
+     * which is sum((-1)^(j-l) * C(j, l) * l^i) over l = 0 ... j.
+     */
+    struct Table {
+        T binomial[D + 1][D + 1] {};
+        T delta[D + 1][D + 1] {};
+
+        Table() {
+            for (size_t i = 0; i <= D; i++) {
+                long long binom {1};
+
+                for (size_t j = 0; j <= i; j++) {
+                    binomial[i][j] = static_cast<T>(binom);
+                    binom = binom * static_cast<long long>(i - j) / static_cast<long long>(j + 1);
+                }
+            }
+
+            for (size_t i = 0; i <= D; i++) {
+                for (size_t j = 0; j <= i; j++) {
+                    long long sum {0};
+                    long long binom {1};
+
+                    for (size_t l = 0; l <= j; l++) {
+                        long long l_p {1};
+                        for (size_t e = 0; e < i; e++)
+                            l_p *= static_cast<long long>(l);
+
+                        sum += (((j - l) & 1) ? -binom : binom) * l_p;
+                        binom = binom * static_cast<long long>(j - l) / static_cast<long long>(l + 1);
+                    }
+
+                    delta[i][j] = static_cast<T>(sum);
+                }
+            }
+        }
+    };
+};
+
+/**
+ * Incremental evaluator of the position, velocity and acceleration polynomials.
+ * Samples are stepped with forward differences and periodically re-anchored
+ * on the exact polynomial to bound the accumulation of rounding errors.
+ */
+template <typename T>
+struct PolynomialStepper {
+    ForwardDifference<T, 7> p;
+    ForwardDifference<T, 6> v;
+    ForwardDifference<T, 5> a;
+
+    int n_current {0};
+    int remaining {0};
+    bool anchored {false};
+
+    /**
+     * Anchor the stepper on the polynomial at sample _n.
+     * 
+     * @param poly      Polynomial to evaluate.
+     * @param _n        Sample at which the stepper is anchored.
+     * @param dt        Time between samples.
+     * @param interval  Amount of steps until the next re-anchor.
+     */
+    void anchor(const Polynomial<T>& poly, int _n, T dt, int interval) {
+        T t {dt * _n};
+
+        p.anchor({poly.p_0, poly.v_0, 0, 0, 
+                  poly.c_3 / 4, poly.c_4 / 5, poly.c_5 / 6, poly.c_6 / 7}, t, dt);
+        v.anchor({poly.v_0, 0, 0, poly.c_3, poly.c_4, poly.c_5, poly.c_6}, t, dt);
+        a.anchor({0, 0, 3 * poly.c_3, 4 * poly.c_4, 5 * poly.c_5, 6 * poly.c_6}, t, dt);
+
+        n_current = _n;
+        remaining = interval;
+        anchored = true;
+    }
+
+    /**
+     * Move the stepper to sample _n. Steps when _n is the successor of the current sample,
+     * otherwise (or when the interval has passed) the stepper is re-anchored.
+     * 
+     * @param poly      Polynomial to evaluate.
+     * @param _n        Sample to move to.
+     * @param dt        Time between samples.
+     * @param interval  Amount of steps between re-anchors.
+     */
+    inline void seek(const Polynomial<T>& poly, int _n, T dt, int interval) {
+        if (anchored and (_n == n_current))
+            return;
+
+        if (anchored and (_n == n_current + 1) and (remaining > 0)) {
+            p.step();
+            v.step();
+            a.step();
+
+            n_current = _n;
+            remaining--;
+            return;
+        }
+
+        anchor(poly, _n, dt, interval);
+    }
+
+    /**
+     * Force a re-anchor on the next seek, e.g. when the polynomial changed.
+     */
+    inline void reset() {
+        anchored = false;
     }
 };
 
@@ -0,0 +1,274 @@
+/**
+ * Copyright (c) 2020 Bas Brussen
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.                                                                         
+ * 
+ * 
+ * @file SampleRange.hpp
+ *
+ * @brief Range and generator interfaces over the samples of a motion.
+ *
+ * @author Bas Brussen
+ * Contact: b.brussen@outlook.com
+ *
+ */
+
+#ifndef SampleRange_hpp
+#define SampleRange_hpp
+
+#include <cstddef>
+#include <iterator>
+#include <utility>
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#define MOTION_COROUTINES 1
+#endif
+#endif
+
+/**
+ * Lazy input range over the states of a motion. Iterating equals the loop
+ * 
+ *      do {
+ *          state = motion.get_state_setpoint();
+ *      } while (motion.increment_motion_sample());
+ * 
+ * so the last state is the one after which increment_motion_sample() returns false.
+ * The iterator only holds the motion: dereferencing samples the current state and 
+ * incrementing advances the motion, so the range compiles to the loop above. Dereference 
+ * an iterator once per position, the motion is advanced by the range so it can be iterated once.
+ * The post-increment samples the state before advancing, so *it++ returns the state of that position.
+ * 
+ * Template arguments:
+ * @param M     Type of the motion, the calls are not virtual unless M has virtual getters.
+ */
+template <typename M>
+class SampleRange {
+public:
+    using state_type = decltype(std::declval<M&>().get_state_setpoint());
+
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = state_type;
+        using difference_type = std::ptrdiff_t;
+        using reference = state_type;
+
+        // Holds the sampled state for operator->.
+        class pointer {
+        public:
+            explicit pointer(state_type state) : 
+                state(state) {}
+
+            const state_type* operator-> () const {
+                return &state;
+            }
+
+        private:
+            state_type state;
+        };
+
+        // Holds the state sampled before the increment for *it++.
+        class proxy {
+        public:
+            explicit proxy(state_type state) : 
+                state(state) {}
+
+            state_type operator* () const {
+                return state;
+            }
+
+        private:
+            state_type state;
+        };
+
+        iterator() {}
+
+        explicit iterator(M* motion) : 
+            motion(motion) {}
+
+        reference operator* () const {
+            return motion->get_state_setpoint();
+        }
+
+        pointer operator-> () const {
+            return pointer(motion->get_state_setpoint());
+        }
+
+        iterator& operator++ () {
+            if (!motion->increment_motion_sample())
+                motion = nullptr;
+            return *this;
+        }
+
+        proxy operator++ (int) {
+            proxy sampled(motion->get_state_setpoint());
+            ++*this;
+            return sampled;
+        }
+
+        // Iterators only differ in being at the end or not.
+        bool operator== (const iterator& it) const {
+            return (motion == nullptr) == (it.motion == nullptr);
+        }
+
+        bool operator!= (const iterator& it) const {
+            return !(*this == it);
+        }
+
+    private:
+        M* motion {nullptr};
+    };
+
+    explicit SampleRange(M& motion) : 
+        motion(&motion) {}
+
+    iterator begin() {
+        return iterator(motion);
+    }
+
+    iterator end() {
+        return iterator();
+    }
+
+private:
+    M* motion;
+};
+
+#if MOTION_COROUTINES
+/**
+ * Minimal generator of C++20 coroutines, std::generator is only available from C++23.
+ * 
+ * Template arguments:
+ * @param V     Type of the yielded values.
+ */
+template <typename V>
+class Generator {
+public:
+    struct promise_type {
+        const V* value {nullptr};
+
+        Generator get_return_object() {
+            return Generator(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+
+        std::suspend_always yield_value(const V& v) noexcept {
+            value = &v;
+            return {};
+        }
+
+        void return_void() {}
+        void unhandled_exception() { throw; }
+    };
+
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = V;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const V*;
+        using reference = const V&;
+
+        // Holds a copy of the value before the increment for *it++, the coroutine overwrites the yielded value.
+        class proxy {
+        public:
+            explicit proxy(const V& value) : 
+                value(value) {}
+
+            reference operator* () const {
+                return value;
+            }
+
+        private:
+            V value;
+        };
+
+        iterator() {}
+
+        explicit iterator(std::coroutine_handle<promise_type> handle) : 
+            handle(handle) {}
+
+        reference operator* () const {
+            return *handle.promise().value;
+        }
+
+        pointer operator-> () const {
+            return handle.promise().value;
+        }
+
+        iterator& operator++ () {
+            handle.resume();
+            return *this;
+        }
+
+        proxy operator++ (int) {
+            proxy previous(**this);
+            ++*this;
+            return previous;
+        }
+
+        bool operator== (const iterator& it) const {
+            return at_end() == it.at_end();
+        }
+
+        bool operator!= (const iterator& it) const {
+            return !(*this == it);
+        }
+
+    private:
+        bool at_end() const {
+            return !handle || handle.done();
+        }
+
+        std::coroutine_handle<promise_type> handle {};
+    };
+
+    Generator(Generator&& g) noexcept : 
+        handle(std::exchange(g.handle, {})) {}
+
+    Generator(const Generator&) = delete;
+    Generator& operator= (const Generator&) = delete;
+
+    ~Generator() {
+        if (handle)
+            handle.destroy();
+    }
+
+    iterator begin() {
+        handle.resume();
+        return iterator(handle);
+    }
+
+    iterator end() {
+        return iterator();
+    }
+
+private:
+    explicit Generator(std::coroutine_handle<promise_type> handle) : 
+        handle(handle) {}
+
+    std::coroutine_handle<promise_type> handle;
+};
+#endif
+
+#endif
@@ -0,0 +1,348 @@
+/**
+ * Copyright (c) 2020 Bas Brussen
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.                                                                         
+ * 
+ * 
+ * @file SampleSink.hpp
+ *
+ * @brief Writes sampled states to a file on a background thread.
+ *
+ * @author Bas Brussen
+ * Contact: b.brussen@outlook.com
+ *
+ */
+
+#ifndef SampleSink_hpp
+#define SampleSink_hpp
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Definitions.hpp"
+
+enum class SampleFormat {
+    // Header followed by blocks, a block holds its amount of samples followed by 3 * N columns:
+    // the positions of every dimension, then the velocities, then the accelerations.
+    columnar,
+    // One line per sample: the positions, velocities and accelerations of every dimension.
+    csv
+};
+
+/**
+ * Header of a columnar sample file. Values are stored in the byte order of the machine which wrote the file.
+ */
+struct SampleFileHeader {
+    static constexpr uint32_t current_version = 1;
+    static constexpr uint32_t byte_order_mark = 0x01020304;
+
+    char magic[4] {'M', 'S', 'M', 'P'};
+    uint32_t version {current_version};
+    uint32_t byte_order {byte_order_mark};
+    uint32_t scalar_size {0};
+    uint32_t dimensions {0};
+    uint32_t reserved {0};
+    uint64_t count {0};
+};
+
+/**
+ * Collects states in a block while a background thread writes the previous block, so sampling
+ * and formatting or writing overlap. Sampling only waits when the writer is a full block behind.
+ * The sink is used from one thread.
+ * 
+ * Template arguments:
+ * @param T     Type of the scalar.
+ * @param N     Number of dimensions.
+ */
+template <typename T, size_t N>
+class SampleSink {
+public:
+    /**
+     * @param block_size    Amount of samples per block, two blocks are allocated.
+     */
+    SampleSink(size_t block_size = 1 << 16) :
+        block_size(block_size),
+        front(block_size),
+        back(block_size) {}
+
+    SampleSink(const char* path, SampleFormat format, size_t block_size = 1 << 16) :
+        SampleSink(block_size) {
+        open(path, format);
+    }
+
+    SampleSink(const SampleSink&) = delete;
+    SampleSink& operator= (const SampleSink&) = delete;
+
+    ~SampleSink() {
+        close();
+    }
+
+    /**
+     * Create the file and start the writer thread.
+     * 
+     * @param path      Path of the file.
+     * @param format    Format of the file.
+     * @return False when the file cannot be created.
+     */
+    bool open(const char* path, SampleFormat format) {
+        close();
+
+        file = std::fopen(path, "wb");
+        if (!file)
+            return false;
+
+        this->format = format;
+        header = SampleFileHeader();
+        header.scalar_size = sizeof(T);
+        header.dimensions = N;
+        used = 0;
+        pending = 0;
+        stop = false;
+        error = false;
+
+        if (format == SampleFormat::columnar)
+            error = std::fwrite(&header, sizeof(header), 1, file) != 1;
+
+        writer = std::thread(&SampleSink::write_blocks, this);
+        return true;
+    }
+
+    bool is_open() const {
+        return file != nullptr;
+    }
+
+    /**
+     * Append states, nothing is appended when the sink is not open.
+     * 
+     * @param states    States to write.
+     * @param count     Amount of states.
+     */
+    void write(const MotionState<T, N>* states, size_t count) {
+        if (!file)
+            return;
+
+        while (count > 0) {
+            size_t c {std::min(count, block_size - used)};
+            std::copy(states, states + c, front.begin() + used);
+
+            used += c;
+            states += c;
+            count -= c;
+
+            if (used == block_size)
+                submit();
+        }
+    }
+
+    void write(const MotionState<T, N>& state) {
+        write(&state, 1);
+    }
+
+    /**
+     * Sample a motion until it is finished and append the states. The states are sampled
+     * into the block with fill_state_setpoints(), without intermediate copies.
+     * 
+     * @param motion    Motion to sample, e.g. a BasicMotion.
+     * @return Amount of states written, 0 when the sink is not open.
+     */
+    template <typename M>
+    size_t write_motion(M& motion) {
+        size_t samples {0};
+        size_t written {0};
+
+        if (!file)
+            return 0;
+
+        do {
+            written = motion.fill_state_setpoints(front.data() + used, block_size - used);
+            used += written;
+            samples += written;
+
+            if (used == block_size)
+                submit();
+        } while (written > 0 && motion.motion_in_progress);
+
+        return samples;
+    }
+
+    /**
+     * Write the remaining states, stop the writer thread and close the file.
+     * 
+     * @return False when writing failed.
+     */
+    bool close() {
+        if (!file)
+            return true;
+
+        if (used > 0)
+            submit();
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            stop = true;
+        }
+        ready.notify_one();
+        writer.join();
+
+        if (format == SampleFormat::columnar && !error)
+            error = std::fseek(file, 0, SEEK_SET) != 0 || std::fwrite(&header, sizeof(header), 1, file) != 1;
+
+        error = (std::fclose(file) != 0) || error;
+        file = nullptr;
+
+        return !error;
+    }
+
+    /**
+     * Amount of states written to the file, including the block which is being written.
+     */
+    uint64_t size() const {
+        return header.count + used;
+    }
+
+private:
+    /**
+     * Hand the front block to the writer, waits until the writer finished the previous block.
+     */
+    void submit() {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return pending == 0; });
+
+        front.swap(back);
+        pending = used;
+        header.count += used;
+        used = 0;
+
+        lock.unlock();
+        ready.notify_one();
+    }
+
+    void write_blocks() {
+        std::vector<T> columns;
+        std::vector<char> text;
+
+        while (true) {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [this] { return pending > 0 || stop; });
+
+            if (pending == 0)
+                return;
+
+            // The back block is not touched by the sampling thread until pending is cleared.
+            size_t count {pending};
+            lock.unlock();
+
+            bool success {format == SampleFormat::columnar ? write_columns(count, columns) : write_csv(count, text)};
+
+            lock.lock();
+            error = error || !success;
+            pending = 0;
+            lock.unlock();
+            done.notify_one();
+        }
+    }
+
+    bool write_columns(size_t count, std::vector<T>& columns) {
+        uint64_t c {count};
+        columns.resize(3 * N * count);
+
+        for (size_t i = 0; i < N; i++) {
+            T* p {columns.data() + i * count};
+            T* v {columns.data() + (N + i) * count};
+            T* a {columns.data() + (2 * N + i) * count};
+
+            for (size_t k = 0; k < count; k++) {
+                p[k] = back[k].position[i];
+                v[k] = back[k].velocity[i];
+                a[k] = back[k].acceleration[i];
+            }
+        }
+
+        return std::fwrite(&c, sizeof(c), 1, file) == 1 
+            && std::fwrite(columns.data(), sizeof(T), columns.size(), file) == columns.size();
+    }
+
+    bool write_csv(size_t count, std::vector<char>& text) {
+        // Values are printed with enough digits to read them back exactly. A field holds the sign, 
+        // the digits, the decimal point, an exponent of at most 4 digits, the comma and the null.
+        static constexpr int digits = std::numeric_limits<T>::max_digits10;
+        static constexpr size_t field = digits + 10;
+        text.resize(count * 3 * N * field);
+
+        char* out {text.data()};
+        for (size_t k = 0; k < count; k++) {
+            const MotionState<T, N>& s {back[k]};
+
+            for (size_t i = 0; i < N; i++)
+                out = print_value(out, field, s.position[i]);
+            for (size_t i = 0; i < N; i++)
+                out = print_value(out, field, s.velocity[i]);
+            for (size_t i = 0; i < N; i++)
+                out = print_value(out, field, s.acceleration[i]);
+
+            if (!out)
+                return false;
+            out[-1] = '\n';
+        }
+
+        size_t length {static_cast<size_t>(out - text.data())};
+        return std::fwrite(text.data(), 1, length, file) == length;
+    }
+
+    /**
+     * Print a value followed by a comma in at most size - 1 characters.
+     * 
+     * @return The end of the printed characters, nullptr when the value was truncated or out is nullptr.
+     */
+    static char* print_value(char* out, size_t size, T value) {
+        if (!out)
+            return nullptr;
+
+        int n {std::snprintf(out, size, "%.*Lg,", std::numeric_limits<T>::max_digits10, static_cast<long double>(value))};
+        if (n < 0 || static_cast<size_t>(n) >= size)
+            return nullptr;
+
+        return out + n;
+    }
+
+    size_t block_size;
+    std::vector<MotionState<T, N>> front;
+    std::vector<MotionState<T, N>> back;
+    size_t used {0};
+
+    std::FILE* file {nullptr};
+    SampleFormat format {SampleFormat::columnar};
+    SampleFileHeader header;
+
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::condition_variable done;
+    size_t pending {0};
+    bool stop {false};
+    bool error {false};
+};
+
+#endif
@@ -0,0 +1,374 @@
+/**
+ * Copyright (c) 2020 Bas Brussen
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.                                                                         
+ * 
+ * 
+ * @file SegmentFile.hpp
+ *
+ * @brief Binary file format of planned motions, which can be replayed without planning.
+ *
+ * @author Bas Brussen
+ * Contact: b.brussen@outlook.com
+ *
+ */
+
+#ifndef SegmentFile_hpp
+#define SegmentFile_hpp
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "MotionHandler.hpp"
+
+/**
+ * The file starts with a header, followed by one record per motion in the order of sampling.
+ * Values are stored in the byte order of the machine which wrote the file, a file of another 
+ * byte order, version, scalar type or amount of dimensions is rejected by the reader.
+ */
+struct SegmentFileHeader {
+    static constexpr uint32_t current_version = 2;
+    static constexpr uint32_t byte_order_mark = 0x01020304;
+
+    char magic[4] {'M', 'S', 'E', 'G'};
+    uint32_t version {current_version};
+    uint32_t byte_order {byte_order_mark};
+    uint32_t scalar_size {0};
+    uint32_t dimensions {0};
+    uint32_t record_size {0};
+    uint64_t count {0};
+};
+
+/**
+ * Stored motion, the members of MotionObject which are required for sampling.
+ */
+template <typename T, size_t N>
+struct SegmentRecord {
+    T c_3, c_4, c_5, c_6, v_0, p_0;
+    T v_target;
+    T dt;
+    T unit_vector[N];
+    T prev_setpoint[N];
+    int32_t n;
+    int32_t is_coast;
+    int32_t blend;
+
+    static SegmentRecord<T, N> from_motion(const MotionObject<T, N>& m) {
+        // Clear the padding as well, so equal motions give equal files.
+        SegmentRecord<T, N> r;
+        std::memset(&r, 0, sizeof(r));
+
+        r.c_3 = m.c_3;
+        r.c_4 = m.c_4;
+        r.c_5 = m.c_5;
+        r.c_6 = m.c_6;
+        r.v_0 = m.v_0;
+        r.p_0 = m.p_0;
+        r.v_target = m.v_target;
+        r.dt = m.dt;
+        std::copy(m.unit_vector.begin(), m.unit_vector.end(), r.unit_vector);
+        std::copy(m.prev_setpoint.begin(), m.prev_setpoint.end(), r.prev_setpoint);
+        r.n = m.n;
+        r.is_coast = m.is_coast;
+        r.blend = m.blend;
+
+        return r;
+    }
+
+    void to_motion(MotionObject<T, N>& m) const {
+        m.c_3 = c_3;
+        m.c_4 = c_4;
+        m.c_5 = c_5;
+        m.c_6 = c_6;
+        m.v_0 = v_0;
+        m.p_0 = p_0;
+        m.v_target = v_target;
+        m.dt = dt;
+        std::copy(unit_vector, unit_vector + N, m.unit_vector.begin());
+        std::copy(prev_setpoint, prev_setpoint + N, m.prev_setpoint.begin());
+        m.n = n;
+        m.is_coast = is_coast != 0;
+        m.blend = blend;
+    }
+};
+
+/**
+ * Writes planned motions to a segment file. The amount of records is stored in the header
+ * when the file is closed.
+ * 
+ * Template arguments:
+ * @param T     Type of the scalar.
+ * @param N     Number of dimensions.
+ */
+template <typename T, size_t N>
+class SegmentWriter {
+public:
+    SegmentWriter() {}
+
+    SegmentWriter(const char* path) {
+        open(path);
+    }
+
+    SegmentWriter(const SegmentWriter&) = delete;
+    SegmentWriter& operator= (const SegmentWriter&) = delete;
+
+    ~SegmentWriter() {
+        close();
+    }
+
+    /**
+     * Create the file and write the header.
+     * 
+     * @param path  Path of the file.
+     * @return False when the file cannot be created.
+     */
+    bool open(const char* path) {
+        close();
+
+        file = std::fopen(path, "wb");
+        if (!file)
+            return false;
+
+        header = SegmentFileHeader();
+        header.scalar_size = sizeof(T);
+        header.dimensions = N;
+        header.record_size = sizeof(SegmentRecord<T, N>);
+
+        return write_header();
+    }
+
+    bool is_open() const {
+        return file != nullptr;
+    }
+
+    /**
+     * Append a single motion.
+     * 
+     * @param m     Motion to store.
+     * @return False when writing failed.
+     */
+    bool write(const MotionObject<T, N>& m) {
+        SegmentRecord<T, N> r {SegmentRecord<T, N>::from_motion(m)};
+
+        if (!file || std::fwrite(&r, sizeof(r), 1, file) != 1)
+            return false;
+
+        header.count++;
+        return true;
+    }
+
+    /**
+     * Move all queued motions of a handler to the file. Planning a large job in parts and 
+     * writing in between keeps the queue, and so the memory, small.
+     * 
+     * @param handler   Handler of which the queue is emptied, e.g. a BasicMotion.
+     * @return False when writing failed.
+     */
+    template <typename Q>
+    bool write(MotionHandler<T, N, Q>& handler) {
+        while (handler.motion_queue_size() > 0) {
+            if (!write(handler.get_motion()))
+                return false;
+        }
+
+        return true;
+    }
+
+    /**
+     * Store the amount of records and close the file.
+     * 
+     * @return False when writing failed.
+     */
+    bool close() {
+        if (!file)
+            return true;
+
+        bool success {std::fseek(file, 0, SEEK_SET) == 0 && write_header()};
+        success = (std::fclose(file) == 0) && success;
+        file = nullptr;
+
+        return success;
+    }
+
+private:
+    bool write_header() {
+        return std::fwrite(&header, sizeof(header), 1, file) == 1;
+    }
+
+    std::FILE* file {nullptr};
+    SegmentFileHeader header;
+};
+
+/**
+ * Memory mapped segment file. The records are read in place, pages are loaded by the
+ * operating system when replayed, so opening a large file takes constant time and only 
+ * the replayed part of the file occupies memory.
+ * 
+ * Template arguments:
+ * @param T     Type of the scalar.
+ * @param N     Number of dimensions.
+ */
+template <typename T, size_t N>
+class SegmentFile {
+public:
+    SegmentFile() {}
+
+    SegmentFile(const char* path) {
+        open(path);
+    }
+
+    SegmentFile(const SegmentFile&) = delete;
+    SegmentFile& operator= (const SegmentFile&) = delete;
+
+    ~SegmentFile() {
+        close();
+    }
+
+    /**
+     * Map the file and validate the header.
+     * 
+     * @param path  Path of the file.
+     * @return False when the file cannot be mapped or does not match T and N.
+     */
+    bool open(const char* path) {
+        close();
+
+        int fd {::open(path, O_RDONLY)};
+        if (fd < 0)
+            return false;
+
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(SegmentFileHeader)) {
+            file_size = static_cast<size_t>(st.st_size);
+            void* p {::mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0)};
+            data = (p == MAP_FAILED) ? nullptr : static_cast<const unsigned char*>(p);
+        }
+        ::close(fd);
+
+        if (!data || !valid()) {
+            close();
+            return false;
+        }
+
+        ::madvise(const_cast<unsigned char*>(data), file_size, MADV_SEQUENTIAL);
+        records = reinterpret_cast<const SegmentRecord<T, N>*>(data + sizeof(SegmentFileHeader));
+        position = 0;
+
+        return true;
+    }
+
+    void close() {
+        if (data)
+            ::munmap(const_cast<unsigned char*>(data), file_size);
+
+        data = nullptr;
+        records = nullptr;
+        file_size = 0;
+        count = 0;
+        position = 0;
+    }
+
+    bool is_open() const {
+        return data != nullptr;
+    }
+
+    /**
+     * Amount of motions in the file.
+     */
+    size_t size() const {
+        return count;
+    }
+
+    /**
+     * True when all motions are replayed.
+     */
+    bool done() const {
+        return position >= count;
+    }
+
+    /**
+     * Restart the replay at the first motion.
+     */
+    void rewind() {
+        position = 0;
+    }
+
+    /**
+     * Append the next motions to the queue of a handler until the queue holds max_queued moves
+     * or the file is replayed. Call it regularly while sampling, e.g. once per control cycle, to 
+     * keep the queue filled with bounded memory. The planner is bypassed, planning after a replay
+     * does not continue from the last replayed position.
+     * 
+     * @param handler       Handler which receives the motions, e.g. a BasicMotion.
+     * @param max_queued    Maximum amount of queued moves, limited by the capacity of the queue.
+     * @return Amount of motions appended.
+     */
+    template <typename Q>
+    size_t replay(MotionHandler<T, N, Q>& handler, size_t max_queued) {
+        size_t appended {0};
+        MotionObject<T, N> m;
+
+        // After the first append the move which is being appended is queued by end_move() as well.
+        while (position < count && handler.motion_queue_size() + (appended > 0 ? 1u : 0u) < max_queued
+               && handler.motion_queue_space() > 0) {
+            records[position++].to_motion(m);
+            handler.append_motion(m);
+            appended++;
+        }
+
+        handler.end_move();
+        return appended;
+    }
+
+private:
+    bool valid() {
+        SegmentFileHeader header;
+        std::memcpy(&header, data, sizeof(header));
+
+        if (std::memcmp(header.magic, SegmentFileHeader().magic, sizeof(header.magic)) != 0
+            || header.byte_order != SegmentFileHeader::byte_order_mark
+            || header.version != SegmentFileHeader::current_version
+            || header.scalar_size != sizeof(T)
+            || header.dimensions != N
+            || header.record_size != sizeof(SegmentRecord<T, N>))
+            return false;
+
+        // A truncated file holds less records than the header states.
+        if (header.count > (file_size - sizeof(header)) / sizeof(SegmentRecord<T, N>))
+            return false;
+
+        count = static_cast<size_t>(header.count);
+        return true;
+    }
+
+    const unsigned char* data {nullptr};
+    const SegmentRecord<T, N>* records {nullptr};
+    size_t file_size {0};
+    size_t count {0};
+    size_t position {0};
+};
+
+#endif
@@ -0,0 +1,271 @@
+/**
+ * Copyright (c) 2020 Bas Brussen
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.                                                                         
+ * 
+ * @file SegmentQueue.hpp
+ *
+ * @brief The segment queue header holds the queue types which can be used to store planned motions.
+ *
+ * @author Bas Brussen
+ * Contact: b.brussen@outlook.com
+ *
+ */
+
+#ifndef SegmentQueue_hpp
+#define SegmentQueue_hpp
+
+#include <array>
+#include <atomic>
+#include <thread>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Wait-free single producer, single consumer ring buffer.
+ * One thread may push (the planner) while another thread fronts and pops (the sampler).
+ * The storage is part of the object, so no allocations are made after construction.
+ * 
+ * Template arguments:
+ * @param S         Type of the stored segments.
+ * @param Capacity  Maximum amount of segments, must be a power of two.
+ */
+template <typename S, size_t Capacity>
+class SpscQueue {
+    static_assert((Capacity > 0) && ((Capacity & (Capacity - 1)) == 0), "Capacity must be a power of two.");
+
+public:
+    SpscQueue() : 
+        head(0), 
+        tail(0) {}
+
+    /**
+     * Push a segment, spins with yield while the queue is full. Producer only.
+     * 
+     * @param s     Segment to push.
+     */
+    void push(S&& s) {
+        while (!try_push(std::move(s)))
+            std::this_thread::yield();
+    }
+
+    void push(const S& s) {
+        S copy = s;
+        push(std::move(copy));
+    }
+
+    /**
+     * Push a segment if there is room. Producer only.
+     * 
+     * @param s     Segment to push.
+     * @return False when the queue is full.
+     */
+    bool try_push(S&& s) {
+        const size_t h {head.load(std::memory_order_relaxed)};
+
+        if (h - tail_cache == Capacity) {
+            tail_cache = tail.load(std::memory_order_acquire);
+
+            if (h - tail_cache == Capacity)
+                return false;
+        }
+
+        buffer[h & mask] = std::move(s);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Oldest segment in the queue. Consumer only, the queue may not be empty.
+     */
+    S& front() {
+        return buffer[tail.load(std::memory_order_relaxed) & mask];
+    }
+
+    /**
+     * Segment i positions after the oldest segment. Consumer only, i must be smaller than size().
+     */
+    const S& at(size_t i) const {
+        return buffer[(tail.load(std::memory_order_relaxed) + i) & mask];
+    }
+
+    /**
+     * Remove the oldest segment. Consumer only, the queue may not be empty.
+     */
+    void pop() {
+        tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /**
+     * Amount of queued segments. Exact on the consumer side with respect to popping, 
+     * may grow concurrently when the producer pushes.
+     */
+    size_t size() const {
+        const size_t t {tail.load(std::memory_order_acquire)};
+        return head.load(std::memory_order_acquire) - t;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    static constexpr size_t capacity() {
+        return Capacity;
+    }
+
+private:
+    static constexpr size_t mask = Capacity - 1;
+
+    // Head and tail are written by different threads, keep them on separate cache lines.
+    alignas(64) std::atomic<size_t> head;
+    size_t tail_cache {0};
+    alignas(64) std::atomic<size_t> tail;
+    alignas(64) std::array<S, Capacity> buffer;
+};
+
+/**
+ * Fixed capacity ring buffer for single threaded use.
+ * The storage is part of the object, so no allocations are made after construction.
+ * 
+ * Template arguments:
+ * @param S         Type of the stored segments.
+ * @param Capacity  Maximum amount of segments, must be a power of two.
+ */
+template <typename S, size_t Capacity>
+class FixedQueue {
+    static_assert((Capacity > 0) && ((Capacity & (Capacity - 1)) == 0), "Capacity must be a power of two.");
+
+public:
+    /**
+     * Push a segment if there is room, see MotionHandler::motion_queue_space().
+     * 
+     * @param s     Segment to push.
+     * @return False when the queue is full, the segment is not pushed.
+     */
+    bool push(S&& s) {
+        if (size() == Capacity)
+            return false;
+
+        buffer[head++ & mask] = std::move(s);
+        return true;
+    }
+
+    bool push(const S& s) {
+        if (size() == Capacity)
+            return false;
+
+        buffer[head++ & mask] = s;
+        return true;
+    }
+
+    S& front() {
+        return buffer[tail & mask];
+    }
+
+    const S& at(size_t i) const {
+        return buffer[(tail + i) & mask];
+    }
+
+    void pop() {
+        tail++;
+    }
+
+    size_t size() const {
+        return head - tail;
+    }
+
+    bool empty() const {
+        return head == tail;
+    }
+
+    static constexpr size_t capacity() {
+        return Capacity;
+    }
+
+private:
+    static constexpr size_t mask = Capacity - 1;
+
+    size_t head {0};
+    size_t tail {0};
+    std::array<S, Capacity> buffer;
+};
+
+/**
+ * Traits of the queue types used by the MotionHandler.
+ * The length counter is shared between threads for concurrent queues.
+ * at() returns segment i positions after the front of the queue, push() returns false
+ * when a queue with a fixed capacity is full. When rejects_when_full is false push() 
+ * always succeeds, it may wait for room.
+ */
+template <typename Q>
+struct queue_traits {
+    using length_type = int;
+    static constexpr size_t capacity = SIZE_MAX;
+    static constexpr bool rejects_when_full = false;
+
+    // std::queue only exposes its container to derived classes.
+    static const typename Q::value_type& at(const Q& q, size_t i) {
+        struct access : Q {
+            static const typename Q::container_type& container(const Q& q) {
+                return q.*(&access::c);
+            }
+        };
+
+        return access::container(q)[i];
+    }
+
+    static bool push(Q& q, const typename Q::value_type& s) {
+        q.push(s);
+        return true;
+    }
+};
+
+template <typename S, size_t Capacity>
+struct queue_traits<SpscQueue<S, Capacity>> {
+    using length_type = std::atomic<int>;
+    static constexpr size_t capacity = Capacity;
+    static constexpr bool rejects_when_full = false;
+
+    static const S& at(const SpscQueue<S, Capacity>& q, size_t i) {
+        return q.at(i);
+    }
+
+    // Waits until the sampler made room.
+    static bool push(SpscQueue<S, Capacity>& q, const S& s) {
+        q.push(s);
+        return true;
+    }
+};
+
+template <typename S, size_t Capacity>
+struct queue_traits<FixedQueue<S, Capacity>> {
+    using length_type = int;
+    static constexpr size_t capacity = Capacity;
+    static constexpr bool rejects_when_full = true;
+
+    static const S& at(const FixedQueue<S, Capacity>& q, size_t i) {
+        return q.at(i);
+    }
+
+    static bool push(FixedQueue<S, Capacity>& q, const S& s) {
+        return q.push(s);
+    }
+};
+
+#endif
@@ -0,0 +1,342 @@
+/**
+ * Copyright (c) 2020 Bas Brussen
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.                                                                         
+ * 
+ * @file Simd.hpp
+ *
+ * @brief The simd header holds vectorized kernels which evaluate a polynomial for consecutive samples.
+ *
+ * @author Bas Brussen
+ * Contact: b.brussen@outlook.com
+ *
+ */
+
+#ifndef Simd_hpp
+#define Simd_hpp
+
+#include <cstddef>
+
+#if defined(__AVX512F__) || defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "Polynomial.hpp"
+
+// The instruction set is selected at compile time (e.g. -mavx2 or -march=native),
+// without any of AVX-512F, AVX2 or SSE2 the scalar fallback is used.
+// The kernels evaluate the same expressions as Polynomial without fused multiply-add, so results equal 
+// the scalar functions for double unless the compiler contracts those (-ffp-contract=fast with FMA or
+// AVX-512F, the default of GCC). tests/simd.cpp compares the kernels of every instruction set.
+
+namespace ml {
+namespace simd {
+    /**
+     * Scalar pack, used as fallback and to evaluate the remaining samples of a block.
+     *
+     * Template arguments:
+     * @param T     Type of the scalar.
+     */
+    template <typename T>
+    struct scalar {
+        static constexpr size_t width = 1;
+        T v;
+
+        static inline scalar set1(T a) { return {a}; }
+        static inline scalar load(const T* p) { return {*p}; }
+        static inline scalar index(int n) { return {static_cast<T>(n)}; }
+        inline void store(T* p) const { *p = v; }
+
+        friend inline scalar operator+ (scalar a, scalar b) { return {a.v + b.v}; }
+        friend inline scalar operator* (scalar a, scalar b) { return {a.v * b.v}; }
+    };
+
+    // Widest pack available for the type, specialized per instruction set.
+    template <typename T>
+    struct pack_type {
+        using type = scalar<T>;
+    };
+
+#if defined(__AVX512F__)
+    struct pack_m512d {
+        static constexpr size_t width = 8;
+        __m512d v;
+
+        static inline pack_m512d set1(double a) { return {_mm512_set1_pd(a)}; }
+        static inline pack_m512d load(const double* p) { return {_mm512_loadu_pd(p)}; }
+        // The unmasked conversions pass an undefined vector through, which GCC reports as 
+        // maybe uninitialized. The zero masked conversion of all lanes is equal.
+        static inline pack_m512d index(int n) {
+            return {_mm512_maskz_cvtepi32_pd(0xFF, _mm256_add_epi32(_mm256_set1_epi32(n), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)))};
+        }
+        inline void store(double* p) const { _mm512_storeu_pd(p, v); }
+
+        friend inline pack_m512d operator+ (pack_m512d a, pack_m512d b) { return {_mm512_add_pd(a.v, b.v)}; }
+        friend inline pack_m512d operator* (pack_m512d a, pack_m512d b) { return {_mm512_mul_pd(a.v, b.v)}; }
+    };
+
+    template <>
+    struct pack_type<double> {
+        using type = pack_m512d;
+    };
+
+    struct pack_m512 {
+        static constexpr size_t width = 16;
+        __m512 v;
+
+        static inline pack_m512 set1(float a) { return {_mm512_set1_ps(a)}; }
+        static inline pack_m512 load(const float* p) { return {_mm512_loadu_ps(p)}; }
+        static inline pack_m512 index(int n) {
+            return {_mm512_maskz_cvtepi32_ps(0xFFFF, _mm512_add_epi32(_mm512_set1_epi32(n),
+                    _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15)))};
+        }
+        inline void store(float* p) const { _mm512_storeu_ps(p, v); }
+
+        friend inline pack_m512 operator+ (pack_m512 a, pack_m512 b) { return {_mm512_add_ps(a.v, b.v)}; }
+        friend inline pack_m512 operator* (pack_m512 a, pack_m512 b) { return {_mm512_mul_ps(a.v, b.v)}; }
+    };
+
+    template <>
+    struct pack_type<float> {
+        using type = pack_m512;
+    };
+#elif defined(__AVX2__)
+    struct pack_m256d {
+        static constexpr size_t width = 4;
+        __m256d v;
+
+        static inline pack_m256d set1(double a) { return {_mm256_set1_pd(a)}; }
+        static inline pack_m256d load(const double* p) { return {_mm256_loadu_pd(p)}; }
+        static inline pack_m256d index(int n) {
+            return {_mm256_cvtepi32_pd(_mm_add_epi32(_mm_set1_epi32(n), _mm_setr_epi32(0, 1, 2, 3)))};
+        }
+        inline void store(double* p) const { _mm256_storeu_pd(p, v); }
+
+        friend inline pack_m256d operator+ (pack_m256d a, pack_m256d b) { return {_mm256_add_pd(a.v, b.v)}; }
+        friend inline pack_m256d operator* (pack_m256d a, pack_m256d b) { return {_mm256_mul_pd(a.v, b.v)}; }
+    };
+
+    template <>
+    struct pack_type<double> {
+        using type = pack_m256d;
+    };
+
+    struct pack_m256 {
+        static constexpr size_t width = 8;
+        __m256 v;
+
+        static inline pack_m256 set1(float a) { return {_mm256_set1_ps(a)}; }
+        static inline pack_m256 load(const float* p) { return {_mm256_loadu_ps(p)}; }
+        static inline pack_m256 index(int n) {
+            return {_mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(n), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)))};
+        }
+        inline void store(float* p) const { _mm256_storeu_ps(p, v); }
+
+        friend inline pack_m256 operator+ (pack_m256 a, pack_m256 b) { return {_mm256_add_ps(a.v, b.v)}; }
+        friend inline pack_m256 operator* (pack_m256 a, pack_m256 b) { return {_mm256_mul_ps(a.v, b.v)}; }
+    };
+
+    template <>
+    struct pack_type<float> {
+        using type = pack_m256;
+    };
+#elif defined(__SSE2__)
+    struct pack_m128d {
+        static constexpr size_t width = 2;
+        __m128d v;
+
+        static inline pack_m128d set1(double a) { return {_mm_set1_pd(a)}; }
+        static inline pack_m128d load(const double* p) { return {_mm_loadu_pd(p)}; }
+        static inline pack_m128d index(int n) {
+            return {_mm_cvtepi32_pd(_mm_add_epi32(_mm_set1_epi32(n), _mm_setr_epi32(0, 1, 0, 0)))};
+        }
+        inline void store(double* p) const { _mm_storeu_pd(p, v); }
+
+        friend inline pack_m128d operator+ (pack_m128d a, pack_m128d b) { return {_mm_add_pd(a.v, b.v)}; }
+        friend inline pack_m128d operator* (pack_m128d a, pack_m128d b) { return {_mm_mul_pd(a.v, b.v)}; }
+    };
+
+    template <>
+    struct pack_type<double> {
+        using type = pack_m128d;
+    };
+
+    struct pack_m128 {
+        static constexpr size_t width = 4;
+        __m128 v;
+
+        static inline pack_m128 set1(float a) { return {_mm_set1_ps(a)}; }
+        static inline pack_m128 load(const float* p) { return {_mm_loadu_ps(p)}; }
+        static inline pack_m128 index(int n) {
+            return {_mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(n), _mm_setr_epi32(0, 1, 2, 3)))};
+        }
+        inline void store(float* p) const { _mm_storeu_ps(p, v); }
+
+        friend inline pack_m128 operator+ (pack_m128 a, pack_m128 b) { return {_mm_add_ps(a.v, b.v)}; }
+        friend inline pack_m128 operator* (pack_m128 a, pack_m128 b) { return {_mm_mul_ps(a.v, b.v)}; }
+    };
+
+    template <>
+    struct pack_type<float> {
+        using type = pack_m128;
+    };
+#endif
+
+    /**
+     * Polynomial constants broadcasted into packs. The constant products are formed
+     * in the same order as in Polynomial.
+     */
+    template <typename P, typename T>
+    struct coefficients {
+        P p_c, p_3, p_4, p_5, p_6, v_0_7, p_0;
+        P c_3, c_4, c_5, c_6, v_0;
+        P a_3, a_4, a_5, a_6;
+        P two, five, six;
+
+        coefficients(const Polynomial<T>& poly) :
+            p_c(P::set1(Polynomial<T>::pol_p_c)),
+            p_3(P::set1(T(105) * poly.c_3)),
+            p_4(P::set1(T(42) * poly.c_4)),
+            p_5(P::set1(T(7) * poly.c_5)),
+            p_6(P::set1(poly.c_6)),
+            v_0_7(P::set1(T(7) * poly.v_0)),
+            p_0(P::set1(poly.p_0)),
+            c_3(P::set1(poly.c_3)),
+            c_4(P::set1(poly.c_4)),
+            c_5(P::set1(poly.c_5)),
+            c_6(P::set1(poly.c_6)),
+            v_0(P::set1(poly.v_0)),
+            a_3(P::set1(T(3) * poly.c_3)),
+            a_4(P::set1(T(4) * poly.c_4)),
+            a_5(P::set1(T(5) * poly.c_5)),
+            a_6(P::set1(T(6) * poly.c_6)),
+            two(P::set1(T(2))),
+            five(P::set1(T(5))),
+            six(P::set1(T(6))) {}
+
+        /**
+         * Constants of a pack of different polynomials, e.g. loaded from a structure of arrays.
+         */
+        coefficients(P c_3, P c_4, P c_5, P c_6, P v_0, P p_0) :
+            p_c(P::set1(Polynomial<T>::pol_p_c)),
+            p_3(P::set1(T(105)) * c_3),
+            p_4(P::set1(T(42)) * c_4),
+            p_5(P::set1(T(7)) * c_5),
+            p_6(c_6),
+            v_0_7(P::set1(T(7)) * v_0),
+            p_0(p_0),
+            c_3(c_3),
+            c_4(c_4),
+            c_5(c_5),
+            c_6(c_6),
+            v_0(v_0),
+            a_3(P::set1(T(3)) * c_3),
+            a_4(P::set1(T(4)) * c_4),
+            a_5(P::set1(T(5)) * c_5),
+            a_6(P::set1(T(6)) * c_6),
+            two(P::set1(T(2))),
+            five(P::set1(T(5))),
+            six(P::set1(T(6))) {}
+
+        inline P position(P t) const {
+            P t_2 = t * t;
+            P t_3 = t_2 * t;
+            P t_4 = t_3 * t;
+            P t_5 = t_4 * t;
+            P t_6 = t_5 * t;
+
+            return p_c * t * (p_3 * t_3 +
+                   two * (p_4 * t_4 +
+                   five * (six * (p_6 * t_6 + v_0_7) +
+                   p_5 * t_5))) + p_0;
+        }
+
+        inline P velocity(P t) const {
+            return (t * t * t) * (t * (t * (c_6 * t + c_5) + c_4) + c_3) + v_0;
+        }
+
+        inline P acceleration(P t) const {
+            P t_2 = t * t;
+            return t_2 * (t * (a_6 * t_2 + a_5 * t + a_4) + a_3);
+        }
+    };
+
+    template <typename T>
+    using pack = typename pack_type<T>::type;
+
+    template <typename T, typename F>
+    inline void evaluate(const Polynomial<T>& poly, int n, T dt, size_t count, T* out, F f) {
+        using P = pack<T>;
+        const coefficients<P, T> c_p(poly);
+        const coefficients<scalar<T>, T> c_s(poly);
+        const P dt_p {P::set1(dt)};
+
+        size_t k = 0;
+        for (; k + P::width <= count; k += P::width)
+            f(c_p, dt_p * P::index(n + static_cast<int>(k))).store(out + k);
+
+        for (; k < count; k++)
+            f(c_s, scalar<T>::set1(dt) * scalar<T>::index(n + static_cast<int>(k))).store(out + k);
+    }
+
+    /**
+     * Evaluate the position polynomial at count consecutive samples starting at sample n.
+     *
+     * @param poly  Polynomial to evaluate.
+     * @param n     First sample.
+     * @param dt    Time between samples.
+     * @param count Amount of samples.
+     * @param out   Buffer of at least count values.
+     */
+    template <typename T>
+    void polynomial_p(const Polynomial<T>& poly, int n, T dt, size_t count, T* out) {
+        evaluate(poly, n, dt, count, out, [](const auto& c, auto t) { return c.position(t); });
+    }
+
+    /**
+     * Evaluate the velocity polynomial at count consecutive samples starting at sample n.
+     *
+     * @param poly  Polynomial to evaluate.
+     * @param n     First sample.
+     * @param dt    Time between samples.
+     * @param count Amount of samples.
+     * @param out   Buffer of at least count values.
+     */
+    template <typename T>
+    void polynomial_v(const Polynomial<T>& poly, int n, T dt, size_t count, T* out) {
+        evaluate(poly, n, dt, count, out, [](const auto& c, auto t) { return c.velocity(t); });
+    }
+
+    /**
+     * Evaluate the acceleration polynomial at count consecutive samples starting at sample n.
+     *
+     * @param poly  Polynomial to evaluate.
+     * @param n     First sample.
+     * @param dt    Time between samples.
+     * @param count Amount of samples.
+     * @param out   Buffer of at least count values.
+     */
+    template <typename T>
+    void polynomial_a(const Polynomial<T>& poly, int n, T dt, size_t count, T* out) {
+        evaluate(poly, n, dt, count, out, [](const auto& c, auto t) { return c.acceleration(t); });
+    }
+}
+}
+
+#endif
@@ -0,0 +1,205 @@
+/**
+ * Copyright (c) 2020 Bas Brussen
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.                                                                         
+ * 
+ * 
+ * @file StaticMotion.hpp
+ *
+ * @brief Moves which are planned and sampled at compile time.
+ *
+ * @author Bas Brussen
+ * Contact: b.brussen@outlook.com
+ *
+ */
+
+#ifndef StaticMotion_hpp
+#define StaticMotion_hpp
+
+#if __cplusplus < 201703L
+#error "StaticMotion.hpp requires C++17"
+#endif
+
+#include "Definitions.hpp"
+
+/**
+ * Move from rest to rest between two points which can be planned in a constant expression, e.g. 
+ * homing or tool change strokes which are known at build time. The phases are rounded with the 
+ * PhaseSolver of the jerk limited planner for a segment which starts and ends at rest (see 
+ * MotionPlanner::set_jerk_limit()) and are stored as the same motion objects, so the samples equal 
+ * those of BasicMotion up to the rounding of the square roots.
+ * 
+ * constexpr StaticMove<double, 3> homing({0, 0, 0}, {0, 0, -20}, 50, 1000, 1000, 20000);
+ * constexpr auto table = make_sample_table<homing.size()>(homing);
+ * 
+ * Template arguments:
+ * @param T     Type of the scalar.
+ * @param N     Number of dimensions.
+ */
+template <typename T, size_t N>
+class StaticMove {
+public:
+    /**
+     * @param from          Start point.
+     * @param to            End point.
+     * @param velocity      Velocity constraint.
+     * @param acceleration  Acceleration constraint.
+     * @param hz            Sample rate.
+     * @param jerk          Jerk constraint, 0 limits the acceleration only.
+     */
+    constexpr StaticMove(const std::array<T, N>& from, const std::array<T, N>& to, 
+                         T velocity, T acceleration, int hz, T jerk = 0) : 
+        hz(hz), 
+        dt(T(1) / hz), 
+        solver {acceleration, jerk, hz} {
+        std::array<T, N> delta = ml::min(to, from);
+        std::array<T, N> unit {ml::constant::unit_vector(delta)};
+        T length {ml::constant::norm(delta)};
+
+        // The end state is held for one sample, as BasicMotion does after the last motion.
+        end = from;
+        if (length <= 0)
+            return;
+
+        T v_p {velocity};
+        T v_exit {0};
+        T t_coast {0};
+
+        if (v_p * solver.transition_time(v_p) <= length)
+            t_coast = (length - v_p * solver.transition_time(v_p)) / v_p;
+        else
+            v_p = peak_velocity(length);
+
+        // Both phases take the same time, the peak velocity is solved from the distance.
+        std::array<int, 3> n {};
+        solver.round_phases(length, T(0), v_p, v_exit, t_coast, n);
+
+        T t_acc {n[0] * dt};
+        T p_acc {T(0.5) * v_p * t_acc};
+
+        phases[0].calc_constants_v(0, v_p, t_acc);
+        set_phase(phases[0], n[0], unit, v_p, 0, false, from);
+
+        set_phase(phases[1], n[1], unit, v_p, p_acc, true, from);
+
+        phases[2].calc_constants_v(v_p, 0, n[2] * dt);
+        set_phase(phases[2], n[2], unit, v_p, p_acc + v_p * (n[1] * dt), false, from);
+
+        end = to;
+    }
+
+    /**
+     * Amount of samples, including the final state which is reached after the last phase.
+     */
+    constexpr size_t size() const {
+        return static_cast<size_t>(phases[0].n + phases[1].n + phases[2].n) + 1;
+    }
+
+    /**
+     * Duration of the move in seconds.
+     */
+    constexpr T duration() const {
+        return (size() - 1) * dt;
+    }
+
+    /**
+     * Get the position, velocity and acceleration of all dimensions at sample k. 
+     * Samples at or after the end of the move return the end point at rest.
+     * 
+     * @param k     Sample counted from the start of the move.
+     * @return MotionState<T, N> of position, velocity and acceleration.
+     */
+    constexpr MotionState<T, N> state(size_t k) const {
+        MotionState<T, N> out {};
+        int n {static_cast<int>(std::min(k, size() - 1))};
+
+        for (const auto& phase : phases) {
+            if (n < phase.n) {
+                phase.get_state(n, out);
+                return out;
+            }
+            n -= phase.n;
+        }
+
+        out.position = end;
+        return out;
+    }
+
+    /**
+     * Acceleration, coast and deceleration phase. Phases without samples are not part of the move.
+     * The phases can be queued on a planner with append_motion() and end_move() to replay the move at runtime.
+     */
+    constexpr const MotionObject<T, N>& phase(size_t i) const {
+        return phases[i];
+    }
+
+private:
+    /**
+     * Peak velocity of a move without coast phase, at which the acceleration and deceleration
+     * take the complete length: v * transition_time(v) = length.
+     */
+    constexpr T peak_velocity(T length) const {
+        // Acceleration limited.
+        T v {ml::constant::sqrt(length * solver.a_target / Polynomial<T>::accel_peak_ratio)};
+
+        // Jerk limited, v^3 * k_j / jerk = length^2.
+        if (solver.jerk > 0 && solver.transition_time(v) > Polynomial<T>::accel_peak_ratio * v / solver.a_target)
+            v = ml::constant::cbrt(length * length * solver.jerk / Polynomial<T>::jerk_peak_ratio);
+
+        return v;
+    }
+
+    constexpr void set_phase(MotionObject<T, N>& m, int n, const std::array<T, N>& unit, 
+                             T velocity, T p_0, bool is_coast, const std::array<T, N>& start) {
+        m.n = n;
+        m.dt = dt;
+        m.unit_vector = unit;
+        m.v_target = velocity;
+        m.is_coast = is_coast;
+        m.p_0 = p_0;
+        m.prev_setpoint = start;
+    }
+
+    int hz;
+    T dt;
+    PhaseSolver<T, SmoothProfile<T>, ml::constant::math> solver;
+
+    std::array<MotionObject<T, N>, 3> phases {};
+    std::array<T, N> end {};
+};
+
+/**
+ * Sample table of a move, see StaticMove::state().
+ * 
+ * Template arguments:
+ * @param S     Amount of samples, usually StaticMove::size().
+ * @param T     Type of the scalar.
+ * @param N     Number of dimensions.
+ */
+template <size_t S, typename T, size_t N>
+constexpr std::array<MotionState<T, N>, S> make_sample_table(const StaticMove<T, N>& move) {
+    std::array<MotionState<T, N>, S> table {};
+
+    for (size_t k = 0; k < S; k++)
+        table[k] = move.state(k);
+
+    return table;
+}
+
+#endif
@@ -0,0 +1,470 @@
+/**
+ * Copyright (c) 2020 Bas Brussen
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.                                                                         
+ * 
+ * 
+ * @file ToolpathReader.hpp
+ *
+ * @brief Streaming reader of text toolpaths, which plans the setpoints while the file is read.
+ *
+ * @author Bas Brussen
+ * Contact: b.brussen@outlook.com
+ *
+ */
+
+#ifndef ToolpathReader_hpp
+#define ToolpathReader_hpp
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+/**
+ * Setpoint of a toolpath with its constraints.
+ */
+template <typename T, size_t N>
+struct ToolpathPoint {
+    std::array<T, N> position {};
+    T velocity {0};
+    T acceleration {0};
+    T v_final {0};
+    bool has_final {false};
+};
+
+/**
+ * Reads a toolpath in chunks of a fixed size, so the memory does not depend on the size of the file.
+ * Two line formats are accepted and may be mixed:
+ * 
+ * - Numbers separated by commas, semicolons or whitespace: N positions, optionally followed by
+ *   the velocity, the acceleration and the final velocity.
+ * - G-code like words: a letter of axes() followed by a position, F followed by a feed rate. 
+ *   The feed rate is per minute as in G-code and is converted to a velocity per second, 
+ *   see set_feed_scale(). Positions and velocity are modal, lines without a position 
+ *   (e.g. G21) are skipped.
+ * 
+ * Empty lines, lines starting with '#' and comments in parentheses or after ';' in G-code are ignored.
+ * Missing constraints are taken from the defaults of the constructor.
+ * 
+ * Template arguments:
+ * @param T     Type of the scalar.
+ * @param N     Number of dimensions.
+ */
+template <typename T, size_t N>
+class ToolpathReader {
+public:
+    /**
+     * @param velocity      Default velocity constraint.
+     * @param acceleration  Default acceleration constraint.
+     * @param chunk_size    Size of the read buffer, the longest line which can be read.
+     */
+    ToolpathReader(T velocity, T acceleration, size_t chunk_size = 1 << 16) :
+        velocity(velocity),
+        acceleration(acceleration),
+        chunk_size(chunk_size),
+        buffer(new char[chunk_size + 1]) {
+        current.velocity = velocity;
+        current.acceleration = acceleration;
+    }
+
+    ToolpathReader(const ToolpathReader&) = delete;
+    ToolpathReader& operator= (const ToolpathReader&) = delete;
+
+    ~ToolpathReader() {
+        close();
+    }
+
+    /**
+     * Open a toolpath file.
+     * 
+     * @param path  Path of the file.
+     * @return False when the file cannot be opened.
+     */
+    bool open(const char* path) {
+        close();
+
+        file = std::fopen(path, "rb");
+        owns_file = true;
+        reset();
+
+        return file != nullptr;
+    }
+
+    /**
+     * Read from an opened stream, e.g. stdin. The stream is not closed by the reader.
+     */
+    void open(std::FILE* stream) {
+        close();
+
+        file = stream;
+        owns_file = false;
+        reset();
+    }
+
+    void close() {
+        if (file && owns_file)
+            std::fclose(file);
+
+        file = nullptr;
+    }
+
+    /**
+     * Letters of the axes in G-code lines, the i-th letter addresses dimension i.
+     * Letters are case insensitive.
+     */
+    void set_axes(const char* letters) {
+        std::strncpy(axes, letters, sizeof(axes) - 1);
+
+        for (char* a = axes; *a; a++) {
+            if (is_letter(*a))
+                *a = static_cast<char>(*a & ~0x20);
+        }
+    }
+
+    /**
+     * Factor from the F word of G-code lines to the velocity, 1/60 by default which converts 
+     * a feed rate per minute (e.g. mm/min) to a velocity per second (mm/s). Use 1 when the 
+     * toolpath holds velocities per second.
+     */
+    void set_feed_scale(T scale) {
+        feed_scale = scale;
+    }
+
+    /**
+     * Read the next setpoint.
+     * 
+     * @param out   Setpoint which receives the values.
+     * @return False at the end of the file or when a line cannot be parsed, see failed().
+     */
+    bool next(ToolpathPoint<T, N>& out) {
+        const char* line_begin;
+        const char* line_end;
+
+        while (!error && next_line(line_begin, line_end)) {
+            line++;
+
+            if (parse_line(line_begin, line_end, out))
+                return true;
+        }
+
+        return false;
+    }
+
+    /**
+     * Plan setpoints until the motion holds max_samples queued samples, the queue of 
+     * the motion is full or the file is read. Call it regularly while sampling, e.g. once 
+     * per control cycle, to keep the motion planned ahead with bounded memory.
+     * 
+     * @param motion        Motion which plans the setpoints, e.g. a BasicMotion.
+     * @param max_samples   Amount of queued samples at which planning pauses.
+     * @return Amount of setpoints planned.
+     */
+    template <typename M>
+    size_t feed(M& motion, long long max_samples) {
+        size_t planned {0};
+        ToolpathPoint<T, N> p;
+
+        // A plan call queues one move.
+        while (motion.motion_length < max_samples && motion.motion_queue_space() > 0 && next(p)) {
+            if (p.has_final)
+                motion.plan(p.position, p.velocity, p.acceleration, p.v_final);
+            else
+                motion.plan(p.position, p.velocity, p.acceleration);
+            planned++;
+        }
+
+        return planned;
+    }
+
+    /**
+     * True when the file is read completely or a line cannot be parsed.
+     */
+    bool done() const {
+        return error || !file || (end_of_file && begin == end);
+    }
+
+    /**
+     * True when a line cannot be parsed, line_number() returns the line.
+     */
+    bool failed() const {
+        return error;
+    }
+
+    size_t line_number() const {
+        return line;
+    }
+
+private:
+    void reset() {
+        begin = end = 0;
+        line = 0;
+        end_of_file = false;
+        error = false;
+        buffer[0] = '\0';
+    }
+
+    /**
+     * Next line in the buffer, reads the next chunk when the buffer holds no complete line.
+     */
+    bool next_line(const char*& line_begin, const char*& line_end) {
+        if (!file)
+            return false;
+
+        while (true) {
+            char* newline {static_cast<char*>(std::memchr(buffer.get() + begin, '\n', end - begin))};
+
+            if (newline || (end_of_file && begin < end)) {
+                line_begin = buffer.get() + begin;
+                line_end = newline ? newline : buffer.get() + end;
+                begin = static_cast<size_t>(line_end - buffer.get()) + (newline ? 1 : 0);
+                return true;
+            }
+
+            if (end_of_file)
+                return false;
+
+            if (begin == 0 && end == chunk_size) {
+                // The line does not fit in the buffer.
+                line++;
+                error = true;
+                return false;
+            }
+
+            // Move the incomplete line to the start of the buffer and append the next chunk.
+            std::memmove(buffer.get(), buffer.get() + begin, end - begin);
+            end -= begin;
+            begin = 0;
+
+            size_t read {std::fread(buffer.get() + end, 1, chunk_size - end, file)};
+            end += read;
+            end_of_file = (read == 0);
+
+            // Terminates a number at the end of the last line for parse_number().
+            buffer[end] = '\0';
+        }
+    }
+
+    /**
+     * @return True when the line holds a setpoint, sets error when it is malformed.
+     */
+    bool parse_line(const char* p, const char* e, ToolpathPoint<T, N>& out) {
+        p = skip_space(p, e);
+
+        if (p == e || *p == '#' || *p == ';' || *p == '(' || *p == '\r')
+            return false;
+
+        bool point {is_letter(*p) ? parse_words(p, e) : parse_numbers(p, e)};
+
+        if (point)
+            out = current;
+
+        return point;
+    }
+
+    bool parse_numbers(const char* p, const char* e) {
+        T values[N + 3];
+        size_t count {0};
+
+        while (p < e && count < N + 3) {
+            if (!parse_number(p, values[count++])) {
+                error = true;
+                return false;
+            }
+
+            p = skip_separators(p, e);
+        }
+
+        if (count < N || skip_space(p, e) != e) {
+            error = true;
+            return false;
+        }
+
+        for (size_t i = 0; i < N; i++)
+            current.position[i] = values[i];
+
+        current.velocity = count > N ? values[N] : velocity;
+        current.acceleration = count > N + 1 ? values[N + 1] : acceleration;
+        current.has_final = count > N + 2;
+        current.v_final = current.has_final ? values[N + 2] : 0;
+
+        return true;
+    }
+
+    bool parse_words(const char* p, const char* e) {
+        bool point {false};
+
+        while (p < e) {
+            char letter {static_cast<char>(*p & ~0x20)};
+
+            if (*p == ';')
+                break;
+
+            if (*p == '(') {
+                while (p < e && *p != ')')
+                    p++;
+                p = skip_space(p + (p < e), e);
+                continue;
+            }
+
+            T value;
+            const char* number {skip_space(p + 1, e)};
+            if (!is_letter(*p) || !parse_number(number, value)) {
+                error = true;
+                return false;
+            }
+            p = skip_space(number, e);
+
+            const char* axis {std::strchr(axes, letter)};
+            if (letter == 'F') {
+                current.velocity = value * feed_scale;
+            }
+            else if (axis && static_cast<size_t>(axis - axes) < N) {
+                current.position[axis - axes] = value;
+                point = true;
+            }
+        }
+
+        current.acceleration = acceleration;
+        current.has_final = false;
+        current.v_final = 0;
+
+        return point;
+    }
+
+    /**
+     * Parse a decimal number. Numbers with at most 19 significant digits and a small exponent 
+     * are exact in double precision with one multiplication or division (Clinger's fast path), 
+     * other numbers fall back to strtod.
+     */
+    static bool parse_number(const char*& p, T& out) {
+        static constexpr double powers[] {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+
+        const char* s {p};
+        bool negative {*s == '-'};
+        if (*s == '-' || *s == '+')
+            s++;
+
+        uint64_t mantissa {0};
+        int digits {0}, exponent {0};
+        bool any {false}, truncated {false};
+
+        for (; is_digit(*s); s++, any = true) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*s - '0');
+                digits += (mantissa != 0);
+            }
+            else {
+                truncated = true;
+            }
+        }
+
+        if (*s == '.') {
+            for (s++; is_digit(*s); s++, any = true) {
+                if (digits < 19) {
+                    mantissa = mantissa * 10 + static_cast<uint64_t>(*s - '0');
+                    digits += (mantissa != 0);
+                    exponent--;
+                }
+                else {
+                    truncated = true;
+                }
+            }
+        }
+
+        if (!any)
+            return false;
+
+        if (*s == 'e' || *s == 'E') {
+            const char* x {s + 1};
+            bool negative_exponent {*x == '-'};
+            if (*x == '-' || *x == '+')
+                x++;
+
+            if (is_digit(*x)) {
+                int e {0};
+                for (; is_digit(*x); x++)
+                    e = std::min(e * 10 + (*x - '0'), 100000);
+                exponent += negative_exponent ? -e : e;
+                s = x;
+            }
+        }
+
+        double value;
+        if (!truncated && mantissa <= (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22) {
+            value = static_cast<double>(mantissa);
+            value = exponent < 0 ? value / powers[-exponent] : value * powers[exponent];
+            value = negative ? -value : value;
+        }
+        else {
+            char* x;
+            value = std::strtod(p, &x);
+            s = x;
+        }
+
+        out = static_cast<T>(value);
+        p = s;
+        return true;
+    }
+
+    static bool is_digit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    static bool is_letter(char c) {
+        return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+    }
+
+    static const char* skip_space(const char* p, const char* e) {
+        while (p < e && (*p == ' ' || *p == '\t' || *p == '\r'))
+            p++;
+        return p;
+    }
+
+    static const char* skip_separators(const char* p, const char* e) {
+        while (p < e && (*p == ' ' || *p == '\t' || *p == '\r' || *p == ',' || *p == ';'))
+            p++;
+        return p;
+    }
+
+    T velocity;
+    T acceleration;
+    ToolpathPoint<T, N> current;
+    char axes[16] {"XYZABCUVW"};
+    T feed_scale {T(1) / T(60)};
+
+    std::FILE* file {nullptr};
+    bool owns_file {false};
+
+    size_t chunk_size;
+    std::unique_ptr<char[]> buffer;
+    size_t begin {0};
+    size_t end {0};
+    size_t line {0};
+    bool end_of_file {false};
+    bool error {false};
+};
+
+#endif
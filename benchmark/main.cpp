@@ -0,0 +1,294 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../Motion/Motion.hpp"
+
+// Benchmark of planning and sampling, built by the motion_benchmark target of CMakeLists.txt:
+//
+//	cmake -S . -B build && cmake --build build --target motion_benchmark
+//
+// Every result is printed as one line "name,type,dimensions,metric,value" on stdout.
+// Store the output of a run and pass it with --baseline to compare a later run against it:
+//
+//	./motion_benchmark > baseline.csv
+//	./motion_benchmark --baseline baseline.csv --tolerance 0.1
+//
+// With a baseline each line gets the ratio to the baseline appended and the exit code is 1
+// when a metric regressed more than the tolerance. Metrics ending in _ns are lower-is-better,
+// all other metrics are higher-is-better. Every benchmark runs --repeat times (default 5) 
+// and the best value of each metric is reported, which filters most of the timing noise.
+
+using Clock = std::chrono::steady_clock;
+
+// Best value of each metric, in order of the first report.
+static std::vector<std::string> keys;
+static std::map<std::string, double> results;
+
+static bool lower_is_better(const std::string& key) {
+	return key.size() > 3 && key.compare(key.size() - 3, 3, "_ns") == 0;
+}
+
+static const char* type_name(float) { return "float"; }
+static const char* type_name(double) { return "double"; }
+
+template <typename T, size_t N>
+void report(const char* name, const char* metric, double value) {
+	char key[128];
+	std::snprintf(key, sizeof(key), "%s,%s,%zu,%s", name, type_name(T()), N, metric);
+	auto it = results.find(key);
+	if (it == results.end()) {
+		keys.push_back(key);
+		results[key] = value;
+	}
+	else {
+		it->second = lower_is_better(key) ? std::min(it->second, value) : std::max(it->second, value);
+	}
+}
+
+// Path of count points. Segments have the given length, every turn-th point changes direction.
+template <typename T, size_t N>
+std::vector<std::array<T, N>> path(size_t count, T length, size_t turn) {
+	std::vector<std::array<T, N>> points;
+	std::array<T, N> p {};
+	std::array<T, N> direction {};
+	direction[0] = 1;
+
+	for (size_t k = 0; k < count; k++) {
+		if (turn > 0 && k % turn == 0) {
+			// Rotate the direction to the next dimension, the corner is 90 degrees.
+			std::rotate(direction.begin(), direction.end() - 1, direction.end());
+			if (N == 1)
+				direction[0] = -direction[0];
+		}
+
+		for (size_t i = 0; i < N; i++)
+			p[i] += direction[i] * length;
+
+		points.push_back(p);
+	}
+
+	return points;
+}
+
+template <typename T, size_t N>
+void bench_plan(const char* name, const std::vector<std::array<T, N>>& points) {
+	auto motion = std::make_unique<BasicMotion<T, N>>(1000);
+
+	auto start = Clock::now();
+	for (auto p : points)
+		motion->plan(p, T(50), T(1000));
+	std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+
+	size_t motions {0};
+	for (int i = 0; i < motion->motion_queue_size(); i++)
+		motions += motion->peek_move(i).phases;
+
+	report<T, N>(name, "plan_ns", elapsed.count() / points.size());
+	report<T, N>(name, "motions_per_plan", static_cast<double>(motions) / points.size());
+	report<T, N>(name, "queue_bytes_per_plan", static_cast<double>(motion->motion_queue_size() * sizeof(MoveRecord<T, N>)) / points.size());
+}
+
+// Latency of a single call, measured per call and sorted into percentiles.
+template <typename T, size_t N, typename F>
+void bench_latency(const char* getter, F sample) {
+	auto motion = std::make_unique<BasicMotion<T, N>>(1000);
+
+	for (auto p : path<T, N>(2000, T(1), 5))
+		motion->plan(p, T(50), T(1000));
+
+	std::vector<double> latency;
+	latency.reserve(motion->motion_length);
+
+	bool in_progress {true};
+	while (in_progress) {
+		auto start = Clock::now();
+		sample(*motion);
+		std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+
+		latency.push_back(elapsed.count());
+		in_progress = motion->increment_motion_sample();
+	}
+
+	std::sort(latency.begin(), latency.end());
+
+	std::string name {std::string("latency_") + getter};
+	report<T, N>(name.c_str(), "p50_ns", latency[latency.size() / 2]);
+	report<T, N>(name.c_str(), "p99_ns", latency[latency.size() * 99 / 100]);
+	report<T, N>(name.c_str(), "p999_ns", latency[latency.size() * 999 / 1000]);
+}
+
+template <typename T, size_t N>
+void bench_throughput() {
+	const auto points = path<T, N>(2000, T(1), 5);
+	std::vector<MotionState<T, N>> block(256);
+
+	auto motion = std::make_unique<BasicMotion<T, N>>(1000);
+	auto start = Clock::now();
+
+	for (auto p : points)
+		motion->plan(p, T(50), T(1000));
+
+	size_t samples {0};
+	bool in_progress {true};
+	while (in_progress) {
+		volatile T sink = motion->get_state_setpoint().position[N - 1];
+		(void) sink;
+		in_progress = motion->increment_motion_sample();
+		samples++;
+	}
+
+	std::chrono::duration<double> elapsed = Clock::now() - start;
+	report<T, N>("end_to_end", "samples_per_s", samples / elapsed.count());
+
+	motion = std::make_unique<BasicMotion<T, N>>(1000);
+	start = Clock::now();
+
+	for (auto p : points)
+		motion->plan(p, T(50), T(1000));
+
+	samples = 0;
+	size_t written {0};
+	do {
+		written = motion->fill_state_setpoints(block.data(), block.size());
+		samples += written;
+	} while (written == block.size() && motion->motion_in_progress);
+
+	elapsed = Clock::now() - start;
+	report<T, N>("end_to_end_block", "samples_per_s", samples / elapsed.count());
+}
+
+// Time per call of a math function over a set of vectors.
+template <typename T, size_t N, typename F>
+void bench_math(const char* name, const std::vector<std::array<T, N>>& vectors, F f) {
+	volatile T sink {0};
+	T sum {0};
+
+	auto start = Clock::now();
+	for (int r = 0; r < 10; r++)
+		for (size_t k = 0; k + 2 < vectors.size(); k++)
+			sum += f(vectors[k], vectors[k + 1], vectors[k + 2]);
+	std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+
+	sink = sum;
+	(void) sink;
+	report<T, N>(name, "call_ns", elapsed.count() / (10 * (vectors.size() - 2)));
+}
+
+template <typename T, size_t N>
+void run_math() {
+	using ml::accuracy;
+	std::vector<std::array<T, N>> vectors(4096);
+	for (size_t k = 0; k < vectors.size(); k++)
+		for (size_t i = 0; i < N; i++)
+			vectors[k][i] = static_cast<T>(((k * 7919 + i * 104729) % 2000) * 0.01 - 10);
+
+	using V = const std::array<T, N>&;
+	bench_math<T, N>("math_norm_exact", vectors, [](V a, V, V) { return ml::norm<accuracy::exact>(a); });
+	bench_math<T, N>("math_norm_fast", vectors, [](V a, V, V) { return ml::norm<accuracy::fast>(a); });
+	bench_math<T, N>("math_norm_std_pow", vectors, [](V a, V, V) { return static_cast<T>(std::pow(ml::dot(a, a), T(0.5))); });
+	bench_math<T, N>("math_norm_fpow", vectors, [](V a, V, V) { return ml::fpow(ml::dot(a, a), T(0.5)); });
+	bench_math<T, N>("math_rnorm_exact", vectors, [](V a, V, V) { return ml::rnorm<accuracy::exact>(a); });
+	bench_math<T, N>("math_rnorm_fast", vectors, [](V a, V, V) { return ml::rnorm<accuracy::fast>(a); });
+	bench_math<T, N>("math_unit_vector_exact", vectors, [](V a, V, V) { return ml::unit_vector<accuracy::exact>(a)[N - 1]; });
+	bench_math<T, N>("math_unit_vector_fast", vectors, [](V a, V, V) { return ml::unit_vector<accuracy::fast>(a)[N - 1]; });
+	bench_math<T, N>("math_angle_ratio_exact", vectors, [](V a, V b, V c) { return ml::angle_ratio<accuracy::exact>(a, b, c); });
+	bench_math<T, N>("math_angle_ratio_fast", vectors, [](V a, V b, V c) { return ml::angle_ratio<accuracy::fast>(a, b, c); });
+}
+
+template <typename T, size_t N>
+void run() {
+	// Short segments only transition, long segments mostly coast.
+	bench_plan<T, N>("plan_short", path<T, N>(20000, T(0.1), 0));
+	bench_plan<T, N>("plan_long", path<T, N>(20000, T(500), 0));
+	bench_plan<T, N>("plan_transition", path<T, N>(20000, T(0.5), 1));
+	bench_plan<T, N>("plan_coast", path<T, N>(20000, T(100), 1));
+
+	bench_latency<T, N>("acceleration", [](BasicMotion<T, N>& m) { volatile T s = m.get_acceleration_setpoint()[0]; (void) s; });
+	bench_latency<T, N>("velocity", [](BasicMotion<T, N>& m) { volatile T s = m.get_velocity_setpoint()[0]; (void) s; });
+	bench_latency<T, N>("position", [](BasicMotion<T, N>& m) { volatile T s = m.get_position_setpoint()[0]; (void) s; });
+	bench_latency<T, N>("state", [](BasicMotion<T, N>& m) { volatile T s = m.get_state_setpoint().position[0]; (void) s; });
+
+	bench_throughput<T, N>();
+	run_math<T, N>();
+}
+
+// Compare the results with a stored run, returns the amount of regressions.
+int compare(const char* file, double tolerance) {
+	std::FILE* f = std::fopen(file, "r");
+	if (!f) {
+		std::fprintf(stderr, "Cannot open baseline %s\n", file);
+		std::exit(2);
+	}
+
+	std::map<std::string, double> baseline;
+	char line[256];
+	while (std::fgets(line, sizeof(line), f)) {
+		char* value = std::strrchr(line, ',');
+		if (!value)
+			continue;
+
+		*value = '\0';
+		baseline[line] = std::strtod(value + 1, nullptr);
+	}
+	std::fclose(f);
+
+	int regressions {0};
+	for (const auto& key : keys) {
+		double value {results[key]};
+		auto it = baseline.find(key);
+		if (it == baseline.end() || it->second == 0) {
+			std::printf("%s,%g,new\n", key.c_str(), value);
+			continue;
+		}
+
+		double ratio {value / it->second};
+		bool regressed {lower_is_better(key) ? ratio > 1 + tolerance : ratio < 1 - tolerance};
+
+		std::printf("%s,%g,%.3f%s\n", key.c_str(), value, ratio, regressed ? ",REGRESSION" : "");
+		regressions += regressed;
+	}
+
+	return regressions;
+}
+
+int main(int argc, char** argv) {
+	const char* baseline {nullptr};
+	double tolerance {0.1};
+	int repeat {5};
+
+	for (int i = 1; i < argc; i++) {
+		if (!std::strcmp(argv[i], "--baseline") && i + 1 < argc)
+			baseline = argv[++i];
+		else if (!std::strcmp(argv[i], "--tolerance") && i + 1 < argc)
+			tolerance = std::strtod(argv[++i], nullptr);
+		else if (!std::strcmp(argv[i], "--repeat") && i + 1 < argc)
+			repeat = std::max(1, std::atoi(argv[++i]));
+	}
+
+	for (int r = 0; r < repeat; r++) {
+		run<float, 1>();
+		run<float, 3>();
+		run<float, 6>();
+		run<float, 9>();
+		run<double, 1>();
+		run<double, 3>();
+		run<double, 6>();
+		run<double, 9>();
+	}
+
+	if (baseline)
+		return compare(baseline, tolerance) > 0;
+
+	for (const auto& key : keys)
+		std::printf("%s,%g\n", key.c_str(), results[key]);
+
+	return 0;
+}
@@ -0,0 +1,23 @@
+/**
+ * Minimal checks for the tests. A failed check is printed and makes the test return 1, 
+ * independent of NDEBUG.
+ */
+
+#ifndef Check_hpp
+#define Check_hpp
+
+#include <cstdio>
+
+static int check_failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            check_failures++; \
+        } \
+    } while (0)
+
+#define CHECK_RESULT() (check_failures > 0 ? 1 : 0)
+
+#endif
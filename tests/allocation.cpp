@@ -0,0 +1,97 @@
+// With FixedQueue or SpscQueue no heap allocations are made after construction, neither by plan()
+// nor by the sampling functions. operator new is replaced to count the allocations.
+
+#include <cstdlib>
+#include <memory>
+#include <new>
+
+#include "Motion/Motion.hpp"
+#include "Check.hpp"
+
+static size_t allocations {0};
+static bool counting {false};
+
+void* operator new(size_t size) {
+    if (counting)
+        allocations++;
+
+    void* p {std::malloc(size)};
+    if (!p)
+        throw std::bad_alloc();
+
+    return p;
+}
+
+// The replaced operators pair malloc with free, which GCC does not see through.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+/**
+ * Plan 2000 points and sample them, the queue is drained whenever a plan call might not fit.
+ * 
+ * @return Amount of allocations.
+ */
+template <typename M>
+static size_t plan_and_sample(M& motion) {
+    std::array<std::array<double, 6>, 64> block;
+    size_t samples {0};
+
+    counting = true;
+    allocations = 0;
+
+    for (int k = 0; k < 2000; k++) {
+        if (motion.motion_queue_space() == 0) {
+            while (motion.motion_queue_size() > 0) {
+                motion.fill_position_setpoints(block.data(), block.size());
+                motion.get_state_setpoint();
+                motion.get_velocity_setpoint();
+                motion.increment_motion_sample();
+                samples++;
+            }
+        }
+
+        motion.plan({double(k % 7), double(k % 3), 1, 2, 3, double(k % 5)}, 50., 1000.);
+    }
+
+    counting = false;
+    CHECK(samples > 0);
+    return allocations;
+}
+
+int main() {
+    auto fixed = std::make_unique<BasicMotion<double, 6, FixedQueue<MoveRecord<double, 6>, 256>>>(1000);
+    auto spsc = std::make_unique<BasicMotion<double, 6, SpscQueue<MoveRecord<double, 6>, 256>>>(1000);
+    auto virtual_fixed = std::make_unique<Motion<double, 6, FixedQueue<MoveRecord<double, 6>, 256>>>(1000);
+
+    size_t fixed_allocations {plan_and_sample(*fixed)};
+    size_t spsc_allocations {plan_and_sample(*spsc)};
+    size_t virtual_allocations {plan_and_sample(*virtual_fixed)};
+
+    std::printf("allocations: FixedQueue %zu, SpscQueue %zu, Motion with FixedQueue %zu\n", 
+                fixed_allocations, spsc_allocations, virtual_allocations);
+
+    CHECK(fixed_allocations == 0);
+    CHECK(spsc_allocations == 0);
+    CHECK(virtual_allocations == 0);
+
+    // A full FixedQueue rejects a push instead of overwriting the oldest segment.
+    FixedQueue<int, 4> queue;
+    for (int i = 0; i < 4; i++)
+        CHECK(queue.push(i));
+
+    CHECK(!queue.push(4));
+    CHECK(queue.size() == 4);
+    CHECK(queue.front() == 0);
+    CHECK(queue.at(3) == 3);
+
+    return CHECK_RESULT();
+}
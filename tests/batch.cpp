@@ -0,0 +1,127 @@
+// plan_batch() queues the same moves as sequential planning, including final velocities, plans
+// no more points than fit in a queue with a fixed capacity and records the plan statistics.
+
+#define MOTION_INSTRUMENTATION 1
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "Motion/Motion.hpp"
+#include "Check.hpp"
+
+using Fixed = BasicMotion<double, 3, FixedQueue<MoveRecord<double, 3>, 64>>;
+
+static std::vector<Point<double, 3>> job(size_t size) {
+    std::vector<Point<double, 3>> points;
+    std::array<double, 3> p {0, 0, 0};
+
+    for (size_t k = 1; k <= size; k++) {
+        p[k % 3] += (k % 7) * 0.3 + 0.1;
+
+        if (k % 50 == 0)
+            points.emplace_back(p, 50., 1000., 5.);
+        else
+            points.emplace_back(p, 50., 1000.);
+    }
+
+    points.emplace_back(p, 50., 1000., 0.);
+    return points;
+}
+
+template <typename M>
+static void plan_sequential(M& motion, const std::vector<Point<double, 3>>& points) {
+    for (const auto& p : points) {
+        if (p.has_final)
+            motion.plan(p.setpoint, p.velocity, p.acceleration, p.v_final);
+        else
+            motion.plan(p.setpoint, p.velocity, p.acceleration);
+    }
+}
+
+/**
+ * Sample both motions to the end, the amount of samples which differ.
+ */
+template <typename A, typename B>
+static size_t compare(A& a, B& b) {
+    size_t different {0};
+    bool in_progress {true};
+
+    while (in_progress) {
+        MotionState<double, 3> x {a.get_state_setpoint()};
+        MotionState<double, 3> y {b.get_state_setpoint()};
+        different += std::memcmp(&x, &y, sizeof(x)) != 0;
+
+        in_progress = a.increment_motion_sample();
+        if (b.increment_motion_sample() != in_progress)
+            return different + 1;
+    }
+
+    return different;
+}
+
+int main() {
+    const std::vector<Point<double, 3>> points {job(5000)};
+
+    // Unbounded queue, planned on four threads.
+    {
+        auto sequential = std::make_unique<BasicMotion<double, 3>>(1000);
+        auto batch = std::make_unique<BasicMotion<double, 3>>(1000);
+
+        plan_sequential(*sequential, points);
+        CHECK(batch->plan_batch(points, 4) == points.size());
+
+        CHECK(batch->motion_queue_size() == sequential->motion_queue_size());
+        CHECK(batch->motion_length == sequential->motion_length);
+        CHECK(batch->statistics.snapshot().plans == points.size());
+        CHECK(compare(*sequential, *batch) == 0);
+    }
+
+    // A queue of 64 moves is filled in chunks while it is sampled.
+    {
+        auto sequential = std::make_unique<BasicMotion<double, 3>>(1000);
+        auto batch = std::make_unique<Fixed>(1000);
+
+        plan_sequential(*sequential, points);
+
+        size_t planned {0};
+        size_t different {0};
+        bool in_progress {true};
+
+        while (in_progress) {
+            if (planned < points.size()) {
+                size_t n {batch->plan_batch(points.data() + planned, points.size() - planned)};
+                CHECK(batch->motion_queue_size() <= 64);
+                planned += n;
+            }
+
+            MotionState<double, 3> x {sequential->get_state_setpoint()};
+            MotionState<double, 3> y {batch->get_state_setpoint()};
+            different += std::memcmp(&x, &y, sizeof(x)) != 0;
+
+            in_progress = sequential->increment_motion_sample();
+            CHECK(batch->increment_motion_sample() == in_progress || planned < points.size());
+        }
+
+        std::printf("fixed queue: planned %zu of %zu points, %zu samples differ\n", planned, points.size(), different);
+        CHECK(planned == points.size());
+        CHECK(different == 0);
+    }
+
+    // Look-ahead mode plans sequentially, with the final velocities.
+    {
+        auto sequential = std::make_unique<BasicMotion<double, 3>>(1000);
+        auto batch = std::make_unique<BasicMotion<double, 3>>(1000);
+        sequential->set_look_ahead(16);
+        batch->set_look_ahead(16);
+
+        plan_sequential(*sequential, points);
+        CHECK(batch->plan_batch(points) == points.size());
+        sequential->flush();
+        batch->flush();
+
+        CHECK(compare(*sequential, *batch) == 0);
+    }
+
+    return CHECK_RESULT();
+}
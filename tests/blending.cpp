@@ -0,0 +1,80 @@
+// Blended corners when the next segment is planned while the previous one is sampled, as when a
+// second thread plans. A segment planned before sampling reaches its overlap gives the same samples
+// as planning everything up front; a later one is not blended, without a position jump.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "Motion/Motion.hpp"
+#include "Check.hpp"
+
+using Position = std::array<double, 3>;
+using State = MotionState<double, 3>;
+
+static const Position p0 {0, 0, 0}, p1 {50, 0, 0}, p2 {50, 50, 0}, p3 {100, 50, 0};
+
+struct Result {
+    std::vector<State> samples;
+    double state_at_error {0};
+};
+
+// Plans the last corner once delay samples are taken, delay < 0 plans it up front.
+static Result sample(int delay) {
+    BasicMotion<double, 3> motion(1000, p0);
+    motion.set_blend_tolerance(0.5);
+    motion.plan(p1, 100, 1000);
+    motion.plan(p2, 100, 1000);
+
+    Result r;
+    bool in_progress {true};
+    for (int k = 0; in_progress || k <= delay; k++) {
+        if (k == std::max(delay, 0)) {
+            motion.plan(p3, 100, 1000);
+            motion.plan(p3, 100, 1000, 0);
+        }
+
+        State s {motion.get_state_setpoint()};
+        State at;
+        if (motion.state_at(motion.sample_time(), at))
+            r.state_at_error = std::max(r.state_at_error, std::fabs(at.position[0] - s.position[0]) + std::fabs(at.position[1] - s.position[1]));
+
+        r.samples.push_back(s);
+        in_progress = motion.increment_motion_sample();
+    }
+
+    return r;
+}
+
+static double largest_step(const std::vector<State>& samples) {
+    double step {0};
+    for (size_t k = 1; k < samples.size(); k++)
+        step = std::max(step, std::hypot(samples[k].position[0] - samples[k - 1].position[0], samples[k].position[1] - samples[k - 1].position[1]));
+
+    return step;
+}
+
+int main() {
+    Result reference {sample(-1)};
+    Result early {sample(500)};
+    bool equal {early.samples.size() == reference.samples.size()
+        && std::memcmp(early.samples.data(), reference.samples.data(), reference.samples.size() * sizeof(State)) == 0};
+    std::printf("up front: %zu samples, planned at 500: %zu samples, equal %d\n", reference.samples.size(), early.samples.size(), equal);
+    CHECK(equal);
+
+    // Inside the overlap of the second corner, and after the end of the second segment.
+    for (int delay : {600, 650, 700}) {
+        Result late {sample(delay)};
+        double step {largest_step(late.samples)};
+        const State& end {late.samples.back()};
+        std::printf("planned at %d: %zu samples, largest step %.4f, state_at error %g, end %g %g\n",
+            delay, late.samples.size(), step, late.state_at_error, end.position[0], end.position[1]);
+        CHECK(step < 0.1 + 1e-9);
+        CHECK(late.state_at_error < 1e-9);
+        CHECK(std::memcmp(&end.position, &reference.samples.back().position, sizeof(Position)) == 0);
+    }
+
+    return CHECK_RESULT();
+}
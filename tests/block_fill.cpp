@@ -0,0 +1,210 @@
+// The fill functions write the same samples as get_*_setpoint() and increment_motion_sample() one
+// sample at a time, for blocks which end on and across the boundaries of motions, in blended corners,
+// with stepping, and when a block only partly fills with the last samples of the motion. The fused
+// get_state_setpoint() equals the separate position, velocity and acceleration setpoints.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "Motion/Motion.hpp"
+#include "Check.hpp"
+
+using Position = std::array<double, 3>;
+using State = MotionState<double, 3>;
+
+enum class Mode { transitions, jerk_limited, blended, stepping };
+
+static std::unique_ptr<BasicMotion<double, 3>> plan(Mode mode) {
+    auto motion = std::make_unique<BasicMotion<double, 3>>(1000);
+    if (mode == Mode::jerk_limited)
+        motion->set_jerk_limit(20000);
+    if (mode == Mode::blended)
+        motion->set_blend_tolerance(0.2);
+    if (mode == Mode::stepping)
+        motion->set_stepping(64);
+
+    Position p {};
+    for (int k = 1; k <= 30; k++) {
+        p[k % 3] += (k % 4) * 2.5 + 0.3;
+        motion->plan(p, 50., 1000.);
+    }
+    motion->plan(p, 50., 1000., 0);
+
+    return motion;
+}
+
+static bool equal(const State& a, const State& b) {
+    return std::memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+// Samples after which a move is taken from the queue, a block which starts there crosses into the next move.
+static std::vector<size_t> boundaries(Mode mode) {
+    auto motion = plan(mode);
+    std::vector<size_t> first;
+    size_t k {0};
+    int queued {motion->motion_queue_size()};
+
+    do {
+        motion->get_state_setpoint();
+        k++;
+
+        if (motion->motion_queue_size() != queued)
+            first.push_back(k);
+        queued = motion->motion_queue_size();
+    } while (motion->increment_motion_sample());
+
+    return first;
+}
+
+// The states of get_state_setpoint() and the separate setpoints, sampled one at a time.
+struct Samples {
+    std::vector<State> states;
+    std::vector<Position> p, v, a;
+};
+
+struct Result {
+    size_t samples {0}, different {0}, last {0}, after_end {0};
+    bool in_progress {true};
+};
+
+/**
+ * Fills the motion in blocks of block_size, after skipping offset samples one at a time, and compares
+ * every field with the states which were sampled one at a time.
+ */
+static Result fill(Mode mode, const Samples& expected, size_t offset, size_t block_size) {
+    auto states = plan(mode);
+    auto positions = plan(mode);
+    auto velocities = plan(mode);
+    auto accelerations = plan(mode);
+
+    Result result;
+    std::vector<State> block(block_size);
+    std::vector<Position> p(block_size), v(block_size), a(block_size);
+
+    for (size_t k = 0; k < offset; k++) {
+        result.different += !equal(states->get_state_setpoint(), expected.states[k]);
+        positions->get_position_setpoint();
+        velocities->get_velocity_setpoint();
+        accelerations->get_acceleration_setpoint();
+
+        states->increment_motion_sample();
+        positions->increment_motion_sample();
+        velocities->increment_motion_sample();
+        accelerations->increment_motion_sample();
+    }
+    result.samples = offset;
+
+    size_t written {0};
+    do {
+        written = states->fill_state_setpoints(block.data(), block_size);
+        size_t written_p {positions->fill_position_setpoints(p.data(), block_size)};
+        size_t written_v {velocities->fill_velocity_setpoints(v.data(), block_size)};
+        size_t written_a {accelerations->fill_acceleration_setpoints(a.data(), block_size)};
+        result.different += written_p != written || written_v != written || written_a != written;
+
+        for (size_t k = 0; k < written; k++) {
+            size_t i {result.samples + k};
+            if (i >= expected.states.size()) {
+                result.different++;
+                continue;
+            }
+
+            result.different += !equal(block[k], expected.states[i]) || p[k] != expected.p[i]
+                || v[k] != expected.v[i] || a[k] != expected.a[i];
+        }
+
+        result.samples += written;
+        result.last = written;
+    } while (written == block_size && states->motion_in_progress);
+
+    result.in_progress = states->motion_in_progress;
+
+    // After the last sample a fill writes the end once more, as get_state_setpoint() would return it.
+    result.after_end = states->fill_state_setpoints(block.data(), block_size);
+    for (size_t k = 0; k < result.after_end; k++)
+        result.different += block[k].position != expected.states.back().position;
+
+    return result;
+}
+
+static void check_mode(const char* name, Mode mode) {
+    auto motion = plan(mode);
+    auto separate = plan(mode);
+    Samples expected;
+    size_t fused {0};
+    bool in_progress {true};
+
+    while (in_progress) {
+        expected.states.push_back(motion->get_state_setpoint());
+        expected.p.push_back(separate->get_position_setpoint());
+        expected.v.push_back(separate->get_velocity_setpoint());
+        expected.a.push_back(separate->get_acceleration_setpoint());
+
+        const State& s {expected.states.back()};
+        fused += expected.p.back() != s.position || expected.v.back() != s.velocity || expected.a.back() != s.acceleration;
+
+        in_progress = motion->increment_motion_sample();
+        fused += separate->increment_motion_sample() != in_progress;
+    }
+
+    const size_t samples {expected.states.size()};
+    std::printf("%s: %zu samples, %zu fused states different from the separate setpoints\n", name, samples, fused);
+
+    // Stepping only applies to the states, the separate setpoints evaluate the polynomials.
+    if (mode != Mode::stepping)
+        CHECK(fused == 0);
+
+    // Blocks shorter and longer than a motion, and one block for the whole motion and more.
+    std::vector<std::pair<size_t, size_t>> runs;
+    for (size_t block_size : {size_t(1), size_t(7), size_t(64), size_t(255), samples, samples + 100}) {
+        for (size_t offset : {size_t(0), size_t(1), size_t(33), samples / 2})
+            runs.push_back({offset, block_size});
+    }
+
+    const size_t general {runs.size()};
+
+    // Blocks of 7 which end on the last sample of a move, cross into the next move or start with it.
+    std::vector<size_t> moves {boundaries(mode)};
+    for (size_t b : moves) {
+        for (size_t before : {7, 3, 0}) {
+            if (b >= before && b - before < samples)
+                runs.push_back({b - before, 7});
+        }
+    }
+
+    size_t failed {0}, after_end {0};
+    for (const auto& run : runs) {
+        const size_t offset {run.first}, block_size {run.second};
+        Result r {fill(mode, expected, offset, block_size)};
+
+        // The last block holds the samples which remain after the last full block.
+        size_t remaining {(samples - offset) % block_size};
+        size_t last {remaining == 0 ? block_size : remaining};
+
+        bool ok {r.different == 0 && r.samples == samples && r.last == last && !r.in_progress};
+        if (!ok)
+            std::printf("%s, blocks of %zu after %zu samples: %zu samples, %zu different, last block %zu of %zu\n",
+                        name, block_size, offset, r.samples, r.different, r.last, last);
+
+        failed += !ok;
+        after_end = std::max(after_end, r.after_end);
+    }
+
+    std::printf("%s: %zu fills, %zu across %zu moves, %zu different, at most %zu samples written after the end\n",
+                name, runs.size(), runs.size() - general, moves.size(), failed, after_end);
+
+    CHECK(failed == 0);
+    CHECK(after_end == 1);
+}
+
+int main() {
+    check_mode("transitions", Mode::transitions);
+    check_mode("jerk limited", Mode::jerk_limited);
+    check_mode("blended", Mode::blended);
+    check_mode("stepping", Mode::stepping);
+
+    return CHECK_RESULT();
+}
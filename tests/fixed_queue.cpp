@@ -0,0 +1,87 @@
+// A full FixedQueue rejects plan() and flush() without planning, after sampling made room the
+// same calls succeed and the samples equal planning with an unbounded queue.
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "Motion/Motion.hpp"
+#include "Check.hpp"
+
+using Position = std::array<double, 3>;
+
+static Position point(int k) {
+    return {double(k % 7), double(k % 3), double(k % 5)};
+}
+
+template <typename M>
+static MotionState<double, 3> sample(M& motion, bool& in_progress) {
+    MotionState<double, 3> state {motion.get_state_setpoint()};
+    in_progress = motion.increment_motion_sample();
+    return state;
+}
+
+/**
+ * Plan 200 points with a queue of 4 moves, sampling only when a plan call is rejected.
+ * 
+ * @param look_ahead    Window of the look-ahead planner, 0 plans from three points.
+ */
+static void check_rejected_points(size_t look_ahead) {
+    using Fixed = BasicMotion<double, 3, FixedQueue<MoveRecord<double, 3>, 4>>;
+
+    std::unique_ptr<Fixed> fixed {new Fixed(1000)};
+    BasicMotion<double, 3> reference(1000);
+    fixed->set_look_ahead(look_ahead);
+    reference.set_look_ahead(look_ahead);
+
+    std::vector<MotionState<double, 3>> samples, expected;
+    size_t rejected {0};
+    bool in_progress {true};
+
+    for (int k = 0; k < 200; k++) {
+        reference.plan(point(k), 50., 1000.);
+
+        while (!fixed->plan(point(k), 50., 1000.)) {
+            int length {fixed->motion_length};
+            rejected++;
+
+            // Nothing is planned, the queue is full.
+            CHECK(fixed->motion_queue_size() == 4);
+            CHECK(fixed->motion_queue_space() == 0);
+            CHECK(fixed->motion_length == length);
+
+            samples.push_back(sample(*fixed, in_progress));
+        }
+    }
+
+    reference.flush();
+    while (!fixed->flush()) {
+        rejected++;
+        samples.push_back(sample(*fixed, in_progress));
+    }
+
+    in_progress = true;
+    while (in_progress)
+        samples.push_back(sample(*fixed, in_progress));
+
+    in_progress = true;
+    while (in_progress)
+        expected.push_back(sample(reference, in_progress));
+
+    bool equal {samples.size() == expected.size() 
+        && std::memcmp(samples.data(), expected.data(), expected.size() * sizeof(expected[0])) == 0};
+
+    std::printf("look-ahead %zu: %zu rejected plan calls, %zu samples, equal to an unbounded queue %d\n", 
+                look_ahead, rejected, samples.size(), equal);
+
+    CHECK(rejected > 0);
+    CHECK(equal);
+}
+
+int main() {
+    check_rejected_points(0);
+    check_rejected_points(8);
+
+    return CHECK_RESULT();
+}
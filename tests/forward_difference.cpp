@@ -0,0 +1,92 @@
+// Drift of the forward difference stepping against direct evaluation of the polynomials,
+// over long segments at 10 kHz and 100 kHz.
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+#include "Motion/Motion.hpp"
+#include "Check.hpp"
+
+struct Drift {
+    double p {0};
+    double v {0};
+    double a {0};
+};
+
+/**
+ * Step one acceleration polynomial from 0 to v_f over t seconds and return the largest
+ * difference with polynomial_pva() at every sample.
+ */
+static Drift drift(int hz, double v_f, double t, int interval) {
+    Polynomial<double> poly;
+    poly.p_0 = 0;
+    poly.calc_constants_v(0, v_f, t);
+
+    const double dt {1.0 / hz};
+    const int samples {static_cast<int>(t * hz)};
+
+    PolynomialStepper<double> stepper;
+    Drift d;
+
+    for (int n = 0; n <= samples; n++) {
+        stepper.seek(poly, n, dt, interval);
+
+        double p, v, a;
+        poly.polynomial_pva(dt * n, p, v, a);
+
+        d.p = std::max(d.p, std::fabs(stepper.p.value() - p));
+        d.v = std::max(d.v, std::fabs(stepper.v.value() - v));
+        d.a = std::max(d.a, std::fabs(stepper.a.value() - a));
+    }
+
+    return d;
+}
+
+int main() {
+    for (int hz : {10000, 100000}) {
+        // A 3 second transition to 50 units/s, 80 units long.
+        Drift anchored {drift(hz, 50, 3, 256)};
+        Drift free {drift(hz, 50, 3, INT_MAX)};
+
+        std::printf("%6d Hz  interval 256: p %.3g v %.3g a %.3g  no re-anchor: p %.3g v %.3g a %.3g\n",
+                    hz, anchored.p, anchored.v, anchored.a, free.p, free.v, free.a);
+
+        CHECK(anchored.p < 1e-11);
+        CHECK(anchored.v < 1e-11);
+        CHECK(anchored.a < 1e-11);
+
+        // Without re-anchoring the drift grows with the amount of samples, but stays bounded.
+        CHECK(free.p < 1e-8);
+        CHECK(free.v < 1e-8);
+        CHECK(free.a < 1e-7);
+    }
+
+    // Stepped sampling of a planned trajectory equals the exact sampling up to the drift.
+    BasicMotion<double, 3> exact(100000), stepped(100000);
+    stepped.set_stepping(256);
+
+    for (BasicMotion<double, 3>* m : {&exact, &stepped}) {
+        m->plan({100, 0, 0}, 50, 100);
+        m->plan({100, 40, 10}, 50, 100, 0);
+    }
+
+    double error {0};
+    bool in_progress {true};
+
+    while (in_progress) {
+        MotionState<double, 3> e {exact.get_state_setpoint()};
+        MotionState<double, 3> s {stepped.get_state_setpoint()};
+
+        for (size_t i = 0; i < 3; i++)
+            error = std::max(error, std::fabs(e.position[i] - s.position[i]));
+
+        in_progress = exact.increment_motion_sample();
+        CHECK(stepped.increment_motion_sample() == in_progress);
+    }
+
+    std::printf("planned trajectory at 100 kHz, interval 256: p %.3g\n", error);
+    CHECK(error < 1e-10);
+
+    return CHECK_RESULT();
+}
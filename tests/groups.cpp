@@ -0,0 +1,62 @@
+// MotionGroups samples every group as a BasicMotion with the same start point would.
+
+#include <cmath>
+
+#include "Motion/MotionGroups.hpp"
+#include "Check.hpp"
+
+int main() {
+    const std::array<double, 3> start {1, 2, 3};
+    const size_t groups {11};
+
+    MotionGroups<double, 3> g(groups, 1000, start);
+    BasicMotion<double, 3> reference(1000, start);
+
+    // Idle groups hold the start point.
+    CHECK(g.update() == 0);
+
+    for (size_t k = 0; k < groups; k++) {
+        MotionState<double, 3> s;
+        g.get_state_setpoint(k, s);
+
+        for (size_t i = 0; i < 3; i++) {
+            CHECK(s.position[i] == start[i]);
+            CHECK(s.velocity[i] == 0);
+        }
+    }
+
+    // One group moves, the others stay at the start point.
+    const size_t moving {5};
+    g.group(moving).plan({10, -4, 3}, 50, 1000);
+    g.group(moving).plan({10, -4, 3}, 50, 1000, 0);
+    reference.plan({10, -4, 3}, 50, 1000);
+    reference.plan({10, -4, 3}, 50, 1000, 0);
+
+    double error {0};
+    bool in_progress {true};
+
+    while (in_progress) {
+        size_t active {g.update()};
+        MotionState<double, 3> r {reference.get_state_setpoint()};
+        in_progress = reference.increment_motion_sample();
+
+        CHECK(active <= 1);
+
+        for (size_t k = 0; k < groups; k++) {
+            MotionState<double, 3> s;
+            g.get_state_setpoint(k, s);
+
+            for (size_t i = 0; i < 3; i++) {
+                if (k == moving)
+                    error = std::max(error, std::fabs(s.position[i] - r.position[i]));
+                else
+                    CHECK(s.position[i] == start[i]);
+            }
+        }
+    }
+
+    std::printf("moving group: largest position difference with BasicMotion %.3g\n", error);
+    CHECK(error < 1e-9);
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,168 @@
+// A velocity transition of calc_constants_v(v_s, v_f, t) is symmetric, with the peak acceleration
+// and jerk which the jerk limited planner assumes. With set_jerk_limit() the samples stay within the
+// acceleration and jerk limit on long segments, short segments and short segments which cap the
+// velocity to stop, and end on the last point. Without it the transition planner passes the same
+// paths without velocity spikes or position jumps.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "Motion/Motion.hpp"
+#include "Check.hpp"
+
+using Position = std::array<double, 3>;
+
+static const double v_max {50};
+static const double a_max {1000};
+static const double dt {1. / 1000};
+
+static double norm(const Position& p) {
+    return std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+}
+
+static void check_transition(double v_s, double v_f, double t) {
+    Polynomial<double> poly;
+    poly.calc_constants_v(v_s, v_f, t);
+
+    // Peaks on a fine grid, the jerk as the difference of the acceleration.
+    const int steps {20000};
+    double a_peak {0}, j_peak {0}, a_previous {poly.polynomial_a(0)};
+    for (int k = 1; k <= steps; k++) {
+        double a {poly.polynomial_a(t * k / steps)};
+        a_peak = std::max(a_peak, std::fabs(a));
+        j_peak = std::max(j_peak, std::fabs(a - a_previous) / (t / steps));
+        a_previous = a;
+    }
+
+    double v_delta {std::fabs(v_f - v_s)};
+    double a_ratio {a_peak * t / v_delta};
+    double j_ratio {j_peak * t * t / v_delta};
+
+    std::printf("transition %g to %g: middle %g, peak acceleration %.6f dv/t, peak jerk %.6f dv/t^2\n",
+                v_s, v_f, poly.polynomial_v(t / 2), a_ratio, j_ratio);
+
+    CHECK(std::fabs(poly.polynomial_v(0) - v_s) < 1e-9);
+    CHECK(std::fabs(poly.polynomial_v(t) - v_f) < 1e-9);
+    CHECK(std::fabs(poly.polynomial_v(t / 2) - (v_s + v_f) / 2) < 1e-9);
+    CHECK(std::fabs(poly.polynomial_a(0)) < 1e-6 && std::fabs(poly.polynomial_a(t)) < 1e-6);
+    CHECK(std::fabs(poly.polynomial_p(t) - (v_s + v_f) / 2 * t) < 1e-9);
+    CHECK(std::fabs(a_ratio - Polynomial<double>::accel_peak_ratio) < 1e-6);
+    CHECK(std::fabs(j_ratio - Polynomial<double>::jerk_peak_ratio) < 1e-3);
+}
+
+enum class Path { long_segments, short_segments, capped };
+
+static std::vector<Position> path(Path kind) {
+    std::vector<Position> points;
+    Position p {};
+
+    for (int k = 0; k < 60; k++) {
+        if (kind == Path::long_segments)
+            p[k % 2] += 10;
+        else if (kind == Path::short_segments)
+            p[k % 2] += 0.2 + (k % 5) * 0.2;
+        else
+            // Straight on, every second segment is too short to stop from the full velocity.
+            p[0] += (k % 2) ? 0.05 : 10;
+
+        points.push_back(p);
+    }
+
+    return points;
+}
+
+struct Peaks {
+    double acceleration {0}, jerk {0}, speed {0}, step {0}, end_error {0};
+};
+
+static Peaks sample(Path kind, double jerk_limit) {
+    std::vector<Position> points {path(kind)};
+
+    auto plan = [&]() {
+        auto motion = std::make_unique<BasicMotion<double, 3>>(1000);
+        motion->set_jerk_limit(jerk_limit);
+        for (const Position& p : points)
+            motion->plan(p, v_max, a_max);
+        motion->plan(points.back(), v_max, a_max, 0);
+        return motion;
+    };
+
+    auto motion = plan();
+    std::vector<MotionState<double, 3>> states;
+    bool in_progress {true};
+    while (in_progress) {
+        states.push_back(motion->get_state_setpoint());
+        in_progress = motion->increment_motion_sample();
+    }
+
+    Peaks peaks;
+    for (size_t k = 0; k < states.size(); k++) {
+        peaks.acceleration = std::max(peaks.acceleration, norm(states[k].acceleration));
+        peaks.speed = std::max(peaks.speed, norm(states[k].velocity));
+
+        if (k == 0)
+            continue;
+
+        Position a, p;
+        for (size_t i = 0; i < 3; i++) {
+            a[i] = states[k].acceleration[i] - states[k - 1].acceleration[i];
+            p[i] = states[k].position[i] - states[k - 1].position[i];
+        }
+
+        peaks.jerk = std::max(peaks.jerk, norm(a) / dt);
+        peaks.step = std::max(peaks.step, norm(p) / (v_max * dt));
+    }
+
+    // The samples stop one sample past the end of the last motion, the end is taken from an unsampled plan.
+    MotionState<double, 3> last;
+    CHECK(plan()->state_at((states.size() - 1 - 1e-6) * dt, last));
+
+    Position end {last.position};
+    peaks.end_error = norm({end[0] - points.back()[0], end[1] - points.back()[1], end[2] - points.back()[2]});
+
+    return peaks;
+}
+
+int main() {
+    check_transition(0, 50, 0.1);
+    check_transition(50, 0, 0.1);
+    check_transition(10, 30, 0.02);
+    check_transition(40, 15, 0.3);
+
+    const char* names[] {"long segments", "short segments", "capped segments"};
+    const Path kinds[] {Path::long_segments, Path::short_segments, Path::capped};
+
+    for (size_t i = 0; i < 3; i++) {
+        for (double jerk : {1e5, 2e4, 5e3}) {
+            Peaks peaks {sample(kinds[i], jerk)};
+
+            std::printf("%s, jerk limit %g: acceleration %.1f, jerk %.0f, speed %.3f, step %.4f v dt, end error %g\n",
+                        names[i], jerk, peaks.acceleration, peaks.jerk, peaks.speed, peaks.step, peaks.end_error);
+
+            CHECK(peaks.acceleration < a_max * (1 + 1e-9));
+            CHECK(peaks.jerk < jerk * (1 + 1e-9));
+            CHECK(peaks.speed < v_max * (1 + 1e-9));
+            CHECK(peaks.step < 1 + 1e-9);
+            CHECK(peaks.end_error < 1e-9);
+        }
+
+        // The transition planner rounds every phase to whole samples and carries the distance to
+        // the next segment, so a segment may end a few hundredths short of its point. It does not
+        // cap the velocity in front of a short segment, which then decelerates beyond the limit.
+        Peaks peaks {sample(kinds[i], 0)};
+
+        std::printf("%s, no jerk limit: acceleration %.1f, speed %.3f, step %.4f v dt, end error %g\n",
+                    names[i], peaks.acceleration, peaks.speed, peaks.step, peaks.end_error);
+
+        if (kinds[i] != Path::capped)
+            CHECK(peaks.acceleration < a_max * 1.02);
+        CHECK(peaks.speed < v_max * (1 + 1e-9));
+        CHECK(peaks.step < 1.5);
+        CHECK(peaks.end_error < 0.06);
+    }
+
+    return CHECK_RESULT();
+}
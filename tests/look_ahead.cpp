@@ -0,0 +1,119 @@
+// Look-ahead planning of paths with short segments stays within the acceleration limit, keeps
+// the speed continuous, passes the corners within their junction velocity and ends at the last point.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "Motion/Motion.hpp"
+#include "Check.hpp"
+
+using Position = std::array<double, 3>;
+
+static const double v_max {50};
+static const double a_max {1000};
+
+static double norm(const Position& p) {
+    return std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+}
+
+// Random walk of segments with lengths between 0 and length, every fourth segment continues straight.
+static std::vector<Position> path(double length, int segments) {
+    std::vector<Position> points;
+    uint32_t seed {11};
+    Position p {}, d {1, 0, 0};
+
+    for (int k = 0; k < segments; k++) {
+        if (k % 4 != 0) {
+            for (size_t i = 0; i < 3; i++) {
+                seed = seed * 1103515245u + 12345u;
+                d[i] = (seed >> 16) % 2000 / 1000.0 - 1;
+            }
+        }
+
+        seed = seed * 1103515245u + 12345u;
+        double l {length * ((seed >> 16) % 1000 + 1) / 1000.0};
+        for (size_t i = 0; i < 3; i++)
+            p[i] += l * d[i] / norm(d);
+
+        points.push_back(p);
+    }
+
+    return points;
+}
+
+static void check_path(const char* name, double length, size_t window) {
+    std::vector<Position> points {path(length, 400)};
+    const double dt {1. / 1000};
+
+    auto plan = [&]() {
+        auto motion = std::make_unique<BasicMotion<double, 3>>(1000);
+        motion->set_look_ahead(window);
+        for (const Position& p : points)
+            motion->plan(p, v_max, a_max);
+        motion->flush();
+        return motion;
+    };
+
+    auto motion = plan();
+
+    std::vector<MotionState<double, 3>> states;
+    bool in_progress {true};
+    while (in_progress) {
+        states.push_back(motion->get_state_setpoint());
+        in_progress = motion->increment_motion_sample();
+    }
+
+    double acceleration {0}, speed {0}, speed_step {0}, junction {0};
+
+    for (size_t k = 0; k < states.size(); k++) {
+        acceleration = std::max(acceleration, norm(states[k].acceleration) / a_max);
+        speed = std::max(speed, norm(states[k].velocity) / v_max);
+
+        if (k == 0)
+            continue;
+
+        double v_0 {norm(states[k - 1].velocity)};
+        double v_1 {norm(states[k].velocity)};
+        speed_step = std::max(speed_step, std::fabs(v_1 - v_0) / (a_max * dt));
+
+        // A corner between the samples, the speed on both sides is limited by the angle.
+        if (v_0 > 1e-6 && v_1 > 1e-6) {
+            double cos_angle {0};
+            for (size_t i = 0; i < 3; i++)
+                cos_angle += states[k - 1].velocity[i] * states[k].velocity[i] / (v_0 * v_1);
+
+            if (cos_angle < 1 - 1e-9) {
+                double limit {v_max * std::max(0.01, cos_angle > 0 ? cos_angle * cos_angle * cos_angle : 0)};
+                junction = std::max(junction, (std::max(v_0, v_1) - a_max * dt) / limit);
+            }
+        }
+    }
+
+    // The samples stop one sample past the end of the last motion, the end is taken from an unsampled plan.
+    MotionState<double, 3> last;
+    CHECK(plan()->state_at((states.size() - 1 - 1e-6) * dt, last));
+
+    Position end {last.position};
+    double end_error {norm({end[0] - points.back()[0], end[1] - points.back()[1], end[2] - points.back()[2]})};
+
+    std::printf("%s: %zu samples, relative to the limits: acceleration %.4f, speed %.4f, speed step %.4f, "
+                "junction speed %.4f, end error %g\n", name, states.size(), acceleration, speed, speed_step, junction, end_error);
+
+    CHECK(acceleration < 1 + 1e-9);
+    CHECK(speed < 1 + 1e-9);
+    CHECK(speed_step < 1 + 1e-9);
+    CHECK(junction < 1 + 1e-9);
+    CHECK(end_error < 1e-9);
+}
+
+int main() {
+    check_path("segments up to 0.2", 0.2, 16);
+    check_path("segments up to 2", 2, 16);
+    check_path("segments up to 20", 20, 8);
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,86 @@
+// Error bounds of the fast geometric functions against the exact ones, and the exact
+// functions for scalar types without a fast estimate (long double), and the element wise functions.
+
+#include <algorithm>
+#include <cmath>
+
+#include "Motion/Motion.hpp"
+#include "Check.hpp"
+
+// Largest relative error of the fast functions over magnitudes from 1e-12 to 1e12.
+template<typename T>
+static double fast_error() {
+    double error {0};
+
+    for (double x = 1e-12; x < 1e12; x *= 1.0137) {
+        const T v {static_cast<T>(x)};
+        const double ref_rsqrt {1 / std::sqrt(static_cast<double>(v))};
+        const double ref_sqrt {std::sqrt(static_cast<double>(v))};
+
+        error = std::max(error, std::fabs(ml::rsqrt<ml::accuracy::fast>(v) - ref_rsqrt) / ref_rsqrt);
+        error = std::max(error, std::fabs(ml::sqrt<ml::accuracy::fast>(v) - ref_sqrt) / ref_sqrt);
+
+        const std::array<T, 3> a {v, static_cast<T>(0.5) * v, static_cast<T>(-0.25) * v};
+        const double ref_norm {std::sqrt(static_cast<double>(ml::dot(a, a)))};
+        error = std::max(error, std::fabs(ml::norm<ml::accuracy::fast>(a) - ref_norm) / ref_norm);
+        error = std::max(error, std::fabs(ml::rnorm<ml::accuracy::fast>(a) * ref_norm - 1));
+
+        const std::array<T, 3> u {ml::unit_vector<ml::accuracy::fast>(a)};
+        const std::array<T, 3> e {ml::unit_vector<ml::accuracy::exact>(a)};
+        for (size_t i = 0; i < 3; i++)
+            error = std::max(error, static_cast<double>(std::fabs(u[i] - e[i])));
+    }
+
+    return error;
+}
+
+template<typename T>
+static double angle_ratio_error() {
+    double error {0};
+
+    for (double angle = 0.05; angle < 3.1; angle += 0.01) {
+        const std::array<T, 2> a {0, 0}, b {1, 0};
+        const std::array<T, 2> c {static_cast<T>(1 + std::cos(angle)), static_cast<T>(std::sin(angle))};
+        const double fast {ml::angle_ratio<ml::accuracy::fast>(a, b, c)};
+        const double exact {ml::angle_ratio<ml::accuracy::exact>(a, b, c)};
+        error = std::max(error, std::fabs(fast - exact) / exact);
+    }
+
+    return error;
+}
+
+int main() {
+    const double float_error {fast_error<float>()}, double_error {fast_error<double>()};
+    std::printf("fast rsqrt/sqrt/norm/rnorm/unit_vector error:  float %.3g  double %.3g\n", float_error, double_error);
+    CHECK(float_error < 5e-6);
+    CHECK(double_error < 5e-6);
+
+    const double float_ratio {angle_ratio_error<float>()}, double_ratio {angle_ratio_error<double>()};
+    std::printf("fast angle_ratio relative error:               float %.3g  double %.3g\n", float_ratio, double_ratio);
+    CHECK(float_ratio < 2e-5);
+    CHECK(double_ratio < 2e-5);
+
+    // The exact functions are the std functions.
+    for (double x = 1e-6; x < 1e6; x *= 1.37) {
+        CHECK(ml::sqrt<ml::accuracy::exact>(x) == std::sqrt(x));
+        CHECK(ml::rsqrt<ml::accuracy::exact>(x) == 1 / std::sqrt(x));
+    }
+
+    // long double has no bit estimate and uses the exact functions in both modes.
+    const std::array<long double, 3> l {3, 4, 12};
+    CHECK(ml::norm<ml::accuracy::exact>(l) == 13);
+    CHECK(ml::norm<ml::accuracy::fast>(l) == 13);
+    CHECK(ml::unit_vector<ml::accuracy::exact>(l)[1] == 4 / 13.0L);
+    CHECK(ml::rsqrt<ml::accuracy::fast>(4.0L) == 0.5L);
+
+    // The element wise functions return arrays, the _expr variants nest in one loop.
+    const std::array<double, 3> a {1, 2, 3}, b {4, 5, 6};
+    static_assert(std::is_same<decltype(ml::add(a, b)), std::array<double, 3>>::value, "add returns an array");
+    static_assert(std::is_same<decltype(ml::min(ml::add_expr(a, b), a)), std::array<double, 3>>::value, 
+                  "expression operands return the array of their operands");
+    const std::array<double, 3> c {ml::div(ml::mul_expr(ml::add_expr(a, b), 2.0), ml::min_expr(b, a))};
+    CHECK(c[0] == 10.0 / 3 && c[1] == 14.0 / 3 && c[2] == 6);
+    CHECK(ml::dot(ml::min_expr(b, a), ml::min_expr(b, a)) == 27);
+
+    return CHECK_RESULT();
+}
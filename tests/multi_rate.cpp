@@ -0,0 +1,174 @@
+// Samplers at several rates and phases of one MultiRateMotion. At the planning rate a sampler
+// equals BasicMotion. A move planned after the samplers reached the end of the trajectory, or
+// inside the overlap of a blended corner, continues without a position jump at every rate.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "Motion/Motion.hpp"
+#include "Motion/MultiRateMotion.hpp"
+#include "Check.hpp"
+
+using Position = std::array<double, 3>;
+
+// Sample rates and phases, all rates divide the tick rate.
+static const int tick_hz {60000};
+static const int rates[] {1000, 20000, 3000, 1000};
+static const double phases[] {0, 0, 0, 0.4e-3};
+
+struct Trace {
+    std::vector<Position> positions;
+    bool in_progress {true};
+};
+
+// Ticks all samplers from tick first up to tick last.
+static void run(MultiRateMotion<double, 3>& motion, std::vector<Trace>& traces, long first, long last) {
+    for (long tick = first; tick < last; tick++) {
+        for (size_t i = 0; i < traces.size(); i++) {
+            if (tick % (tick_hz / rates[i]) != 0)
+                continue;
+
+            traces[i].positions.push_back(motion.get_state_setpoint(i).position);
+            traces[i].in_progress = motion.increment_motion_sample(i);
+        }
+    }
+}
+
+static double largest_step(const std::vector<Position>& positions) {
+    double step {0};
+    for (size_t k = 1; k < positions.size(); k++) {
+        double d {0};
+        for (size_t i = 0; i < 3; i++)
+            d += (positions[k][i] - positions[k - 1][i]) * (positions[k][i] - positions[k - 1][i]);
+
+        step = std::max(step, std::sqrt(d));
+    }
+
+    return step;
+}
+
+static void check_continuous(const char* name, const std::vector<Trace>& traces, double velocity, const Position& end) {
+    for (size_t i = 0; i < traces.size(); i++) {
+        const std::vector<Position>& p {traces[i].positions};
+        double step {largest_step(p)};
+        double error {std::fabs(p.back()[0] - end[0]) + std::fabs(p.back()[1] - end[1]) + std::fabs(p.back()[2] - end[2])};
+
+        std::printf("%s, %d Hz: %zu samples, largest step %.5f, end error %g\n", name, rates[i], p.size(), step, error);
+
+        CHECK(step < velocity / rates[i] + 1e-9);
+        CHECK(error < 1e-3);
+        CHECK(!traces[i].in_progress);
+    }
+}
+
+static MultiRateMotion<double, 3> samplers(std::vector<Trace>& traces) {
+    MultiRateMotion<double, 3> motion(1000, Position {});
+    for (size_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++)
+        motion.add_sampler(rates[i], phases[i]);
+
+    traces.assign(motion.sampler_count(), Trace());
+    return motion;
+}
+
+int main() {
+    // Planned up front, the planning rate sampler equals BasicMotion.
+    {
+        BasicMotion<double, 3> reference(1000);
+        MultiRateMotion<double, 3> motion(1000);
+        size_t sampler {motion.add_sampler(1000)};
+
+        Position p {};
+        for (int k = 1; k <= 50; k++) {
+            p[k % 3] += (k % 7) * 0.5 + 1;
+            reference.plan(p, 50., 1000.);
+            motion.plan(p, 50., 1000.);
+        }
+
+        size_t samples {0}, different {0};
+        bool in_progress {true};
+        while (in_progress) {
+            MotionState<double, 3> a {reference.get_state_setpoint()};
+            MotionState<double, 3> b {motion.get_state_setpoint(sampler)};
+            samples++;
+
+            in_progress = reference.increment_motion_sample();
+            CHECK(motion.increment_motion_sample(sampler) == in_progress);
+
+            // BasicMotion holds the end state one sample after the end of the last motion.
+            different += in_progress && std::memcmp(&a, &b, sizeof(a)) != 0;
+        }
+
+        std::printf("planned up front: %zu samples, %zu different from BasicMotion\n", samples, different);
+        CHECK(different == 0);
+    }
+
+    // The queue runs dry for 100 ms before the next move is planned.
+    {
+        std::vector<Trace> traces;
+        MultiRateMotion<double, 3> motion {samplers(traces)};
+
+        // Nothing is planned yet, the samplers hold the start point.
+        run(motion, traces, 0, tick_hz / 100);
+        motion.plan({10, 0, 0}, 50, 1000);
+        motion.plan({10, 0, 0}, 50, 1000, 0);
+        run(motion, traces, tick_hz / 100, tick_hz);
+
+        for (const Trace& trace : traces)
+            CHECK(!trace.in_progress);
+
+        run(motion, traces, tick_hz, tick_hz + tick_hz / 10);
+        motion.plan({10, 10, 0}, 50, 1000);
+        motion.plan({10, 10, 0}, 50, 1000, 0);
+        run(motion, traces, tick_hz + tick_hz / 10, 3 * tick_hz);
+
+        check_continuous("starved", traces, 50, {10, 10, 0});
+    }
+
+    // The last corner is planned while the samplers are inside the overlap of the blended corner
+    // before it. The planning rate sampler equals BasicMotion with the same late plan.
+    {
+        const Position p1 {50, 0, 0}, p2 {50, 50, 0}, p3 {100, 50, 0};
+        const long late {tick_hz * 65 / 100};
+
+        std::vector<Trace> traces;
+        MultiRateMotion<double, 3> motion {samplers(traces)};
+        motion.set_blend_tolerance(0.5);
+        motion.plan(p1, 100, 1000);
+        motion.plan(p2, 100, 1000);
+        run(motion, traces, 0, late);
+        motion.plan(p3, 100, 1000);
+        motion.plan(p3, 100, 1000, 0);
+        run(motion, traces, late, 3 * tick_hz);
+
+        check_continuous("late blend", traces, 100, p3);
+
+        BasicMotion<double, 3> reference(1000, Position {});
+        reference.set_blend_tolerance(0.5);
+        reference.plan(p1, 100, 1000);
+        reference.plan(p2, 100, 1000);
+
+        std::vector<Position> expected;
+        bool in_progress {true};
+        for (long k = 0; in_progress || k <= late / (tick_hz / 1000); k++) {
+            if (k == late / (tick_hz / 1000)) {
+                reference.plan(p3, 100, 1000);
+                reference.plan(p3, 100, 1000, 0);
+            }
+
+            expected.push_back(reference.get_state_setpoint().position);
+            in_progress = reference.increment_motion_sample();
+        }
+
+        // Up to the hold sample of BasicMotion.
+        const std::vector<Position>& sampled {traces[0].positions};
+        bool equal {sampled.size() >= expected.size()
+            && std::memcmp(sampled.data(), expected.data(), (expected.size() - 1) * sizeof(Position)) == 0};
+        std::printf("late blend, 1000 Hz: equal to BasicMotion %d\n", equal);
+        CHECK(equal);
+    }
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,95 @@
+// The buffer and profile policies of the planner are resolved at compile time. Policies which 
+// wrap the defaults plan the same trajectory and see every point and velocity change.
+
+#include <cstring>
+
+#include "Motion/Motion.hpp"
+#include "Motion/FixedMotion.hpp"
+#include "Motion/MultiRateMotion.hpp"
+#include "Check.hpp"
+
+static size_t appended_points {0};
+static size_t velocity_changes {0};
+
+template <typename T, size_t N>
+class CountingBuffer : public SetpointBuffer<T, N> {
+public:
+    CountingBuffer() {}
+
+    CountingBuffer(std::array<T, N>& p) : 
+        SetpointBuffer<T, N>(p) {}
+
+protected:
+    void append_buffer(const Point<T, N>& p) {
+        appended_points++;
+        SetpointBuffer<T, N>::append_buffer(p);
+    }
+};
+
+template <typename T>
+struct CountingProfile : SmoothProfile<T> {
+    template <typename... Args>
+    static void velocity_change(Polynomial<T>& poly, Args... args) {
+        velocity_changes++;
+        SmoothProfile<T>::velocity_change(poly, args...);
+    }
+};
+
+using Counted = BasicMotion<double, 3, std::queue<MoveRecord<double, 3>>, 
+                            CountingBuffer<double, 3>, CountingProfile<double>>;
+
+template <typename M>
+static void plan(M& motion) {
+    motion.plan({10, 0, 0}, 50, 1000);
+    motion.plan({10, 10, 0}, 50, 1000);
+    motion.plan({20, 10, 5}, 20, 500);
+    motion.plan({0, 0, 0}, 50, 1000, 0);
+}
+
+int main() {
+    BasicMotion<double, 3> reference(1000);
+    Counted counted(1000);
+
+    plan(reference);
+    plan(counted);
+
+    std::printf("points %zu, velocity changes %zu\n", appended_points, velocity_changes);
+    CHECK(appended_points == 4);
+    CHECK(velocity_changes > 0);
+
+    size_t samples {0}, different {0};
+    bool in_progress {true};
+
+    while (in_progress) {
+        MotionState<double, 3> a {reference.get_state_setpoint()};
+        MotionState<double, 3> b {counted.get_state_setpoint()};
+
+        different += std::memcmp(&a, &b, sizeof(a)) != 0;
+        samples++;
+
+        in_progress = reference.increment_motion_sample();
+        CHECK(counted.increment_motion_sample() == in_progress);
+    }
+
+    CHECK(samples > 1000);
+    CHECK(different == 0);
+
+    // The other planners take the same policies.
+    Motion<double, 3, std::queue<MoveRecord<double, 3>>, CountingBuffer<double, 3>, CountingProfile<double>> virtual_motion(1000);
+    MultiRateMotion<double, 3, std::queue<MoveRecord<double, 3>>, CountingBuffer<double, 3>, CountingProfile<double>> multi_rate(1000);
+    FixedMotion<double, 3, ml::q15_16, std::queue<MoveRecord<double, 3>>, CountingBuffer<double, 3>, CountingProfile<double>> fixed(1000);
+
+    plan(virtual_motion);
+    plan(multi_rate);
+    plan(fixed);
+
+    BasicMotion<double, 3> planned(1000);
+    plan(planned);
+
+    CHECK(appended_points == 16);
+    CHECK(virtual_motion.motion_length == planned.motion_length);
+    CHECK(multi_rate.motion_length == planned.motion_length);
+    CHECK(fixed.motion_length == planned.motion_length);
+
+    return CHECK_RESULT();
+}
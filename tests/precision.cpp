@@ -0,0 +1,79 @@
+// Position error of float and fixed point sampling against BasicMotion<double, 3>, for random
+// paths of 1000 segments at 1 kHz with steps of up to 0.5, 5 and 50 per axis. The positions
+// stay within the range of q15_16.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "Motion/Motion.hpp"
+#include "Motion/FixedMotion.hpp"
+#include "Check.hpp"
+
+struct Error {
+    double p {0};
+    double v {0};
+    size_t samples {0};
+    bool equal_length {true};
+};
+
+// Deterministic random walk, every axis moves up to length per segment.
+template<typename M, typename T>
+static void plan_path(M& motion, double length) {
+    uint32_t seed {7};
+    std::array<double, 3> p {};
+
+    for (int k = 0; k < 1000; k++) {
+        for (size_t i = 0; i < 3; i++) {
+            seed = seed * 1103515245u + 12345u;
+            p[i] += length * ((seed >> 16) % 2000 / 1000.0 - 1);
+        }
+
+        motion.plan({static_cast<T>(p[0]), static_cast<T>(p[1]), static_cast<T>(p[2])}, T(50), T(1000));
+    }
+}
+
+template<typename M, typename T>
+static Error error(double length) {
+    BasicMotion<double, 3> reference(1000);
+    M motion(1000);
+    plan_path<BasicMotion<double, 3>, double>(reference, length);
+    plan_path<M, T>(motion, length);
+
+    Error e;
+    bool in_progress {true};
+    while (in_progress) {
+        auto r = reference.get_state_setpoint();
+        auto s = motion.get_state_setpoint();
+
+        for (size_t i = 0; i < 3; i++) {
+            e.p = std::max(e.p, std::fabs(static_cast<double>(s.position[i]) - r.position[i]));
+            e.v = std::max(e.v, std::fabs(static_cast<double>(s.velocity[i]) - r.velocity[i]));
+        }
+
+        e.samples++;
+        in_progress = reference.increment_motion_sample();
+        e.equal_length = e.equal_length && (motion.increment_motion_sample() == in_progress);
+    }
+
+    return e;
+}
+
+int main() {
+    for (double length : {0.5, 5.0, 50.0}) {
+        Error f {error<BasicMotion<float, 3>, float>(length)};
+        Error q {error<FixedMotion<double, 3, ml::q15_16>, double>(length)};
+        Error fq {error<FixedMotion<float, 3, ml::q15_16>, float>(length)};
+
+        std::printf("length %4.1f: float p %.2g v %.2g, q15_16 p %.2g v %.2g, float planned q15_16 p %.2g v %.2g (%zu samples)\n", 
+                    length, f.p, f.v, q.p, q.v, fq.p, fq.v, f.samples);
+
+        CHECK(f.equal_length && q.equal_length && fq.equal_length);
+        CHECK(f.p < 1e-3);
+        CHECK(q.p < 2e-3);
+        CHECK(fq.p < 2e-3);
+        CHECK(q.v < 1e-2);
+    }
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,95 @@
+// The sample range yields the same states as the manual sampling loop, also with *it++ and with
+// the coroutine generator, and creating its iterators does not advance the motion.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "Motion/Motion.hpp"
+#include "Check.hpp"
+
+template<typename M>
+static void plan(M& motion) {
+    std::array<double, 3> p {};
+    for (int k = 1; k <= 50; k++) {
+        p[k % 3] += (k % 7) * 0.5 + 1;
+        motion.plan(p, 50., 1000.);
+    }
+}
+
+int main() {
+    std::vector<MotionState<double, 3>> manual, range;
+
+    BasicMotion<double, 3> a(1000);
+    plan(a);
+    bool in_progress {true};
+    while (in_progress) {
+        manual.push_back(a.get_state_setpoint());
+        in_progress = a.increment_motion_sample();
+    }
+
+    BasicMotion<double, 3> b(1000);
+    plan(b);
+    // Neither begin() nor dereferencing advances the motion, the loop below still yields every state.
+    auto samples = b.samples();
+    auto it = samples.begin();
+    CHECK(it != samples.end());
+    CHECK((*it).position == (*samples.begin()).position);
+
+    for (const auto& state : samples)
+        range.push_back(state);
+
+    std::printf("manual %zu states, range %zu states\n", manual.size(), range.size());
+    CHECK(manual.size() == range.size());
+    CHECK(std::memcmp(manual.data(), range.data(), manual.size() * sizeof(manual[0])) == 0);
+
+    // Composes with the standard algorithms, and operator-> reads the same state.
+    Motion<double, 3> c(1000);
+    plan(c);
+    auto r = c.samples();
+    auto first = r.begin();
+    CHECK(first->position == manual.front().position);
+    const auto fast = std::count_if(r.begin(), r.end(), [](const MotionState<double, 3>& s) { 
+        return std::fabs(s.velocity[0]) > 40; 
+    });
+    const auto expected = std::count_if(manual.begin(), manual.end(), [](const MotionState<double, 3>& s) { 
+        return std::fabs(s.velocity[0]) > 40; 
+    });
+    CHECK(fast == expected);
+
+    // The post-increment returns the state before the increment, as std::copy_n of an input iterator needs.
+    BasicMotion<double, 3> d(1000);
+    plan(d);
+    auto s = d.samples();
+    std::vector<MotionState<double, 3>> post;
+    for (auto i = s.begin(); i != s.end();)
+        post.push_back(*i++);
+
+    BasicMotion<double, 3> e(1000);
+    plan(e);
+    auto t = e.samples();
+    std::vector<MotionState<double, 3>> copied(10);
+    std::copy_n(t.begin(), copied.size(), copied.begin());
+
+    std::printf("post-increment %zu states\n", post.size());
+    CHECK(post.size() == manual.size());
+    CHECK(std::memcmp(manual.data(), post.data(), manual.size() * sizeof(manual[0])) == 0);
+    CHECK(std::memcmp(manual.data(), copied.data(), copied.size() * sizeof(copied[0])) == 0);
+
+#if MOTION_COROUTINES
+    BasicMotion<double, 3> f(1000);
+    plan(f);
+    auto generator = f.sample_generator();
+    std::vector<MotionState<double, 3>> yielded;
+    for (auto i = generator.begin(); i != generator.end();)
+        yielded.push_back(*i++);
+
+    std::printf("generator %zu states\n", yielded.size());
+    CHECK(yielded.size() == manual.size());
+    CHECK(std::memcmp(manual.data(), yielded.data(), manual.size() * sizeof(manual[0])) == 0);
+#endif
+
+    return CHECK_RESULT();
+}
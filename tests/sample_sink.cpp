@@ -0,0 +1,75 @@
+// CSV output of the sample sink reads back exactly for double and long double, and writing
+// to a sink which is not open does nothing.
+
+#include <cstdlib>
+#include <cstring>
+
+#include "Motion/Motion.hpp"
+#include "Motion/SampleSink.hpp"
+#include "Check.hpp"
+
+// Write states with values of the full precision of T and compare them with the file.
+template<typename T>
+static void round_trip(const char* path) {
+    const size_t count {1000};
+    std::vector<MotionState<T, 2>> states(count);
+    for (size_t k = 0; k < count; k++) {
+        states[k].position = {T(1) / T(k + 3), -T(k) * T(1e7) / T(7)};
+        states[k].velocity = {std::numeric_limits<T>::max() / T(k + 1), std::numeric_limits<T>::denorm_min()};
+        states[k].acceleration = {-std::numeric_limits<T>::lowest() / T(3), T(k)};
+    }
+
+    // Blocks of 64 samples, so several blocks are submitted.
+    SampleSink<T, 2> sink(path, SampleFormat::csv, 64);
+    CHECK(sink.is_open());
+    sink.write(states.data(), count);
+    CHECK(sink.close());
+
+    std::FILE* file {std::fopen(path, "rb")};
+    CHECK(file != nullptr);
+    if (!file)
+        return;
+
+    char line[512];
+    size_t lines {0}, mismatches {0};
+    while (std::fgets(line, sizeof(line), file) && lines < count) {
+        const MotionState<T, 2>& s {states[lines]};
+        const T expected[6] {s.position[0], s.position[1], s.velocity[0], s.velocity[1], s.acceleration[0], s.acceleration[1]};
+
+        char* p {line};
+        for (size_t i = 0; i < 6; i++) {
+            char* end;
+            T value {static_cast<T>(std::strtold(p, &end))};
+            if (end == p || value != expected[i])
+                mismatches++;
+            p = end + 1;
+        }
+
+        lines++;
+    }
+    std::fclose(file);
+    std::remove(path);
+
+    std::printf("%zu byte scalar: %zu lines, %zu mismatches\n", sizeof(T), lines, mismatches);
+    CHECK(lines == count);
+    CHECK(mismatches == 0);
+}
+
+int main() {
+    round_trip<double>("test_sample_sink_double.csv");
+    round_trip<long double>("test_sample_sink_long_double.csv");
+
+    // A sink which is not open ignores the states instead of waiting for a writer.
+    SampleSink<double, 3> closed(4);
+    std::vector<MotionState<double, 3>> states(10);
+    closed.write(states.data(), states.size());
+    closed.write(states.data(), states.size());
+    CHECK(closed.size() == 0);
+
+    BasicMotion<double, 3> motion(1000);
+    motion.plan({1, 0, 0}, 10, 100);
+    CHECK(closed.write_motion(motion) == 0);
+    CHECK(closed.close());
+
+    return CHECK_RESULT();
+}
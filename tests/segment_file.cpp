@@ -0,0 +1,197 @@
+// A job planned in parts and written with SegmentWriter replays from the memory mapped SegmentFile
+// to the same samples as BasicMotion. Files of another scalar type, amount of dimensions, byte order
+// or version, and truncated files, are rejected.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "Motion/Motion.hpp"
+#include "Motion/SegmentFile.hpp"
+#include "Check.hpp"
+
+using Position = std::array<double, 3>;
+
+static const char* file_name {"test_segment_file.mseg"};
+static const char* modified_name {"test_segment_file_modified.mseg"};
+
+static std::vector<Position> points() {
+    std::vector<Position> p(200, Position {});
+
+    for (size_t k = 1; k < p.size(); k++) {
+        p[k] = p[k - 1];
+        p[k][k % 3] += (k % 5) * 0.7 + 0.2;
+    }
+
+    return p;
+}
+
+template <typename M>
+static std::vector<MotionState<double, 3>> sample(M& motion) {
+    std::vector<MotionState<double, 3>> states;
+    bool in_progress {true};
+
+    while (in_progress) {
+        states.push_back(motion.get_state_setpoint());
+        in_progress = motion.increment_motion_sample();
+    }
+
+    return states;
+}
+
+static std::vector<unsigned char> read_file(const char* name) {
+    std::vector<unsigned char> bytes;
+    std::FILE* f {std::fopen(name, "rb")};
+    if (!f)
+        return bytes;
+
+    int c;
+    while ((c = std::fgetc(f)) != EOF)
+        bytes.push_back(static_cast<unsigned char>(c));
+
+    std::fclose(f);
+    return bytes;
+}
+
+static void write_file(const char* name, const std::vector<unsigned char>& bytes) {
+    std::FILE* f {std::fopen(name, "wb")};
+    std::fwrite(bytes.data(), 1, bytes.size(), f);
+    std::fclose(f);
+}
+
+// Writes the file with a 32 bit field of the header replaced, returns true when it opens.
+static bool opens_modified(const std::vector<unsigned char>& bytes, size_t offset, uint32_t value) {
+    std::vector<unsigned char> modified {bytes};
+    std::memcpy(modified.data() + offset, &value, sizeof(value));
+    write_file(modified_name, modified);
+
+    SegmentFile<double, 3> file;
+    return file.open(modified_name);
+}
+
+template <typename T, size_t N>
+static bool writes_and_opens_as_double_3() {
+    {
+        BasicMotion<T, N> motion(1000);
+        std::array<T, N> p {};
+        p[0] = 10;
+        motion.plan(p, 50, 1000);
+        motion.plan(p, 50, 1000, 0);
+
+        SegmentWriter<T, N> writer(modified_name);
+        CHECK(writer.write(motion));
+    }
+
+    SegmentFile<double, 3> file;
+    return file.open(modified_name);
+}
+
+static void check_replay() {
+    std::vector<Position> path {points()};
+
+    // Reference, planned and sampled at once.
+    auto reference = std::make_unique<BasicMotion<double, 3>>(1000);
+    for (const Position& p : path)
+        reference->plan(p, 50., 1000.);
+    reference->plan(path.back(), 50., 1000., 0);
+    std::vector<MotionState<double, 3>> expected {sample(*reference)};
+
+    // Planned in parts, the queue is moved to the file every 16 points.
+    size_t written {0};
+    {
+        auto motion = std::make_unique<BasicMotion<double, 3>>(1000);
+        SegmentWriter<double, 3> writer(file_name);
+
+        for (size_t k = 0; k < path.size(); k++) {
+            motion->plan(path[k], 50., 1000.);
+            if (k % 16 == 15) {
+                written = std::max(written, static_cast<size_t>(motion->motion_queue_size()));
+                CHECK(writer.write(*motion));
+            }
+        }
+
+        motion->plan(path.back(), 50., 1000., 0);
+        CHECK(writer.write(*motion));
+        CHECK(writer.close());
+    }
+
+    SegmentFile<double, 3> file;
+    CHECK(file.open(file_name));
+
+    // Replayed while sampling with at most 8 queued moves.
+    auto motion = std::make_unique<BasicMotion<double, 3>>(1000);
+    std::vector<MotionState<double, 3>> replayed;
+    size_t queued {0};
+    bool in_progress {true};
+
+    while (in_progress) {
+        file.replay(*motion, 8);
+        queued = std::max(queued, static_cast<size_t>(motion->motion_queue_size()));
+
+        replayed.push_back(motion->get_state_setpoint());
+        in_progress = motion->increment_motion_sample() || !file.done();
+    }
+
+    bool equal {replayed.size() == expected.size()
+        && std::memcmp(replayed.data(), expected.data(), expected.size() * sizeof(MotionState<double, 3>)) == 0};
+
+    std::printf("replay: %zu motions, at most %zu moves written at once and %zu moves queued, %zu samples, "
+                "equal to BasicMotion %d\n", file.size(), written, queued, replayed.size(), equal);
+
+    CHECK(file.done());
+    CHECK(queued <= 8);
+    CHECK(equal);
+
+    // A rewound file replays again.
+    file.rewind();
+    auto again = std::make_unique<BasicMotion<double, 3>>(1000);
+    while (!file.done())
+        file.replay(*again, 1 << 20);
+
+    std::vector<MotionState<double, 3>> second {sample(*again)};
+    CHECK(second.size() == expected.size()
+        && std::memcmp(second.data(), expected.data(), expected.size() * sizeof(MotionState<double, 3>)) == 0);
+}
+
+static void check_rejected() {
+    std::vector<unsigned char> bytes {read_file(file_name)};
+    CHECK(bytes.size() > sizeof(SegmentFileHeader));
+
+    bool other_type {writes_and_opens_as_double_3<float, 3>()};
+    bool other_dimensions {writes_and_opens_as_double_3<double, 2>()};
+    bool same {writes_and_opens_as_double_3<double, 3>()};
+
+    bool swapped {opens_modified(bytes, offsetof(SegmentFileHeader, byte_order), 0x04030201)};
+    bool version {opens_modified(bytes, offsetof(SegmentFileHeader, version), SegmentFileHeader::current_version + 1)};
+    bool magic {opens_modified(bytes, offsetof(SegmentFileHeader, magic), 0)};
+
+    std::vector<unsigned char> truncated(bytes.begin(), bytes.end() - 1);
+    write_file(modified_name, truncated);
+    SegmentFile<double, 3> file;
+    bool short_file {file.open(modified_name)};
+
+    std::printf("opened: float %d, 2 dimensions %d, double 3 dimensions %d, swapped byte order %d, "
+                "next version %d, other magic %d, truncated %d\n",
+                other_type, other_dimensions, same, swapped, version, magic, short_file);
+
+    CHECK(!other_type);
+    CHECK(!other_dimensions);
+    CHECK(same);
+    CHECK(!swapped);
+    CHECK(!version);
+    CHECK(!magic);
+    CHECK(!short_file);
+}
+
+int main() {
+    check_replay();
+    check_rejected();
+
+    std::remove(file_name);
+    std::remove(modified_name);
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,144 @@
+// The block kernels of Motion/Simd.hpp equal the scalar evaluation of Polynomial for float and
+// double, for blocks which are no multiple of the pack width and blocks which start at any sample.
+// With fused multiply-adds they are as precise as the scalar evaluation. The file is built once per
+// instruction set which the compiler supports, see CMakeLists.txt.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "Motion/Simd.hpp"
+#include "Check.hpp"
+
+// Return code of a test which ctest reports as skipped.
+static const int skipped {77};
+
+static const char* instruction_set() {
+#if defined(__AVX512F__)
+    return "AVX-512F";
+#elif defined(__AVX2__)
+    return "AVX2";
+#elif defined(__SSE2__)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+static bool supported() {
+#if defined(__GNUC__) && defined(__AVX512F__)
+    return __builtin_cpu_supports("avx512f");
+#elif defined(__GNUC__) && defined(__AVX2__)
+    return __builtin_cpu_supports("avx2");
+#else
+    return true;
+#endif
+}
+
+struct Errors {
+    double kernel {0}, scalar {0}, different {0};
+};
+
+/**
+ * Differences of the kernels and the scalar functions from the same polynomial evaluated in long double
+ * precision, and from each other, relative to the scale of position, velocity and acceleration.
+ */
+template <typename T>
+static void compare(const Polynomial<T>& poly, const double (&scale)[3], int n, T dt, size_t count, Errors& errors) {
+    std::vector<T> p(count), v(count), a(count);
+    ml::simd::polynomial_p<T>(poly, n, dt, count, p.data());
+    ml::simd::polynomial_v<T>(poly, n, dt, count, v.data());
+    ml::simd::polynomial_a<T>(poly, n, dt, count, a.data());
+
+    Polynomial<T> s {poly};
+    Polynomial<long double> d;
+    d.c_3 = poly.c_3;
+    d.c_4 = poly.c_4;
+    d.c_5 = poly.c_5;
+    d.c_6 = poly.c_6;
+    d.v_0 = poly.v_0;
+    d.p_0 = poly.p_0;
+
+    for (size_t k = 0; k < count; k++) {
+        T t {dt * static_cast<T>(n + static_cast<int>(k))};
+        long double exact[3] {d.polynomial_p(t), d.polynomial_v(t), d.polynomial_a(t)};
+        T scalar[3] {s.polynomial_p(t), s.polynomial_v(t), s.polynomial_a(t)};
+        T kernel[3] {p[k], v[k], a[k]};
+
+        for (size_t i = 0; i < 3; i++) {
+            double kernel_error {static_cast<double>(std::fabs(kernel[i] - exact[i])) / scale[i]};
+            double scalar_error {static_cast<double>(std::fabs(scalar[i] - exact[i])) / scale[i]};
+
+            errors.kernel = std::max(errors.kernel, kernel_error);
+            errors.scalar = std::max(errors.scalar, scalar_error);
+            errors.different = std::max(errors.different, std::fabs(static_cast<double>(kernel[i]) - scalar[i]) / scale[i]);
+        }
+    }
+}
+
+template <typename T>
+static void check_type(const char* name, double epsilon, bool contracted) {
+    uint32_t seed {7};
+    auto random = [&seed](double low, double high) {
+        seed = seed * 1103515245u + 12345u;
+        return low + (high - low) * ((seed >> 8) % 100000) / 100000.0;
+    };
+
+    Errors errors;
+    size_t blocks {0};
+
+    for (int i = 0; i < 200; i++) {
+        Polynomial<T> poly;
+        double v_s {random(-50, 50)}, v_f {random(-50, 50)};
+        T t {static_cast<T>(random(0.005, 0.5))};
+        poly.calc_constants_v(static_cast<T>(v_s), static_cast<T>(v_f), t);
+        poly.p_0 = static_cast<T>(random(-100, 100));
+
+        double v_max {std::max(std::fabs(v_s), std::fabs(v_f))};
+        const double scale[3] {std::fabs(poly.p_0) + v_max * t, v_max, Polynomial<double>::accel_peak_ratio * std::fabs(v_f - v_s) / t};
+
+        int samples {static_cast<int>(t * 1000)};
+
+        // Blocks of every length up to two packs of 16 floats, from the start and the middle of the polynomial.
+        for (size_t count = 1; count <= 33; count++) {
+            for (int n : {0, 1, samples / 2, samples - static_cast<int>(count)}) {
+                if (n < 0)
+                    continue;
+
+                compare<T>(poly, scale, n, T(1e-3), count, errors);
+                blocks++;
+            }
+        }
+    }
+
+    std::printf("%s, %s with %zu lanes: %zu blocks, largest relative error of the kernels %g, of the scalar functions %g, "
+                "largest relative difference %g\n", instruction_set(), name, ml::simd::pack<T>::width, blocks,
+                errors.kernel, errors.scalar, errors.different);
+
+    // Equal unless the compiler contracts the products into fused multiply-adds, as with AVX-512F, which
+    // changes the rounding of every sample but not the precision of the kernels.
+    if (contracted)
+        CHECK(errors.kernel < 2 * errors.scalar + epsilon);
+    else
+        CHECK(errors.different == 0);
+}
+
+int main() {
+    if (!supported()) {
+        std::printf("%s is not supported by this processor\n", instruction_set());
+        return skipped;
+    }
+
+#if defined(__FMA__) || defined(__AVX512F__)
+    const bool contracted {true};
+#else
+    const bool contracted {false};
+#endif
+
+    check_type<double>("double", 1e-15, contracted);
+    check_type<float>("float", 1e-6, contracted);
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,101 @@
+// One thread plans into an SpscQueue with room for four moves while a second thread samples, so
+// plan() waits for the sampler most of the time. The sampled trajectory equals a single threaded run.
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Motion/Motion.hpp"
+#include "Check.hpp"
+
+using Position = std::array<double, 3>;
+
+static std::vector<Position> path() {
+    std::vector<Position> points;
+    Position p {};
+
+    for (int k = 1; k <= 300; k++) {
+        p[k % 3] += (k % 7) * 0.3 + 0.1;
+        points.push_back(p);
+    }
+
+    return points;
+}
+
+// The planner lags one point, from three points the last point is planned again to stop at it.
+template <typename M>
+static void plan_path(M& motion, const std::vector<Position>& points, size_t look_ahead, size_t& full) {
+    for (const Position& p : points) {
+        full += motion.motion_queue_space() == 0;
+        motion.plan(p, 50., 1000.);
+    }
+
+    if (look_ahead > 0)
+        motion.flush();
+    else
+        motion.plan(points.back(), 50., 1000., 0);
+}
+
+/**
+ * @param look_ahead    Window of the look-ahead planner, 0 plans from three points.
+ */
+static void check_threads(size_t look_ahead) {
+    std::vector<Position> points {path()};
+
+    // Single threaded reference.
+    auto reference = std::make_unique<BasicMotion<double, 3>>(1000);
+    size_t full {0};
+    reference->set_look_ahead(look_ahead);
+    plan_path(*reference, points, look_ahead, full);
+
+    std::vector<MotionState<double, 3>> expected;
+    bool in_progress {true};
+    while (in_progress) {
+        expected.push_back(reference->get_state_setpoint());
+        in_progress = reference->increment_motion_sample();
+    }
+
+    auto motion = std::make_unique<BasicMotion<double, 3, SpscQueue<MoveRecord<double, 3>, 4>>>(1000);
+    motion->set_look_ahead(look_ahead);
+
+    std::atomic<bool> planned {false};
+    full = 0;
+
+    std::thread planner([&]() {
+        plan_path(*motion, points, look_ahead, full);
+        planned = true;
+    });
+
+    // The sampler only samples when a move is queued. A queue which runs dry would end or hold the
+    // trajectory until the planner catches up, which a single thread never does.
+    std::vector<MotionState<double, 3>> sampled;
+    in_progress = true;
+    while (in_progress) {
+        while (!planned && motion->motion_queue_size() == 0)
+            std::this_thread::yield();
+
+        sampled.push_back(motion->get_state_setpoint());
+        in_progress = motion->increment_motion_sample();
+    }
+
+    planner.join();
+
+    bool equal {sampled.size() == expected.size()
+        && std::memcmp(sampled.data(), expected.data(), expected.size() * sizeof(MotionState<double, 3>)) == 0};
+
+    std::printf("look-ahead %zu: %zu samples, %zu plan calls on a full queue, equal to a single thread %d\n",
+                look_ahead, sampled.size(), full, equal);
+
+    CHECK(full > 0);
+    CHECK(equal);
+}
+
+int main() {
+    check_threads(0);
+    check_threads(16);
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,166 @@
+// state_at_sample(k) returns the k-th sampled state, across the boundaries of motions and moves,
+// in blended corners and while the motion is being sampled. Samples of finished motions and
+// samples which are not planned yet are refused, state_at() agrees at the times of the samples.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "Motion/Motion.hpp"
+#include "Check.hpp"
+
+using Position = std::array<double, 3>;
+
+static std::vector<Position> path() {
+    std::vector<Position> points;
+    Position p {};
+
+    for (int k = 1; k <= 40; k++) {
+        p[k % 3] += (k % 4) * 2.5 + 0.3;
+        points.push_back(p);
+    }
+
+    return points;
+}
+
+static bool equal(const MotionState<double, 3>& a, const MotionState<double, 3>& b) {
+    return std::memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+static double distance(const MotionState<double, 3>& a, const MotionState<double, 3>& b) {
+    double d {0};
+    for (size_t i = 0; i < 3; i++)
+        d = std::max({d, std::fabs(a.position[i] - b.position[i]), std::fabs(a.velocity[i] - b.velocity[i]) * 1e-3});
+
+    return d;
+}
+
+static std::unique_ptr<BasicMotion<double, 3>> plan(int mode, size_t points) {
+    auto motion = std::make_unique<BasicMotion<double, 3>>(1000);
+    if (mode == 1)
+        motion->set_jerk_limit(20000);
+    if (mode == 2)
+        motion->set_blend_tolerance(0.2);
+
+    std::vector<Position> p {path()};
+    for (size_t k = 0; k < points; k++)
+        motion->plan(p[k], 50., 1000.);
+
+    if (points == p.size())
+        motion->plan(p.back(), 50., 1000., 0);
+
+    return motion;
+}
+
+static void check_mode(const char* name, int mode) {
+    auto reference = plan(mode, path().size());
+    std::vector<MotionState<double, 3>> sampled;
+    bool in_progress {true};
+    while (in_progress) {
+        sampled.push_back(reference->get_state_setpoint());
+        in_progress = reference->increment_motion_sample();
+    }
+
+    // The last sample holds the end one sample after the last motion, it is not part of a motion.
+    const long long samples {static_cast<long long>(sampled.size()) - 1};
+
+    // Everything planned, nothing sampled.
+    auto motion = plan(mode, path().size());
+    size_t different {0}, refused {0};
+    double time_error {0};
+    MotionState<double, 3> state;
+
+    for (long long k = 0; k < samples; k++) {
+        if (!motion->state_at_sample(k, state)) {
+            refused++;
+            continue;
+        }
+
+        different += !equal(state, sampled[k]);
+
+        if (motion->state_at(k * 1e-3, state))
+            time_error = std::max(time_error, distance(state, sampled[k]));
+    }
+
+    bool after_end {motion->state_at_sample(samples + 1, state) || motion->state_at(samples * 1e-3 + 0.5, state)};
+    bool before_start {motion->state_at_sample(-1, state)};
+
+    std::printf("%s: %lld samples, %zu refused, %zu different from sampling, state_at %g from the samples, "
+                "after the end %d, before the start %d\n",
+                name, samples, refused, different, time_error, after_end, before_start);
+
+    CHECK(refused == 0);
+    CHECK(different == 0);
+    CHECK(time_error < 1e-9);
+    CHECK(!after_end);
+    CHECK(!before_start);
+
+    // While sampling, the current sample and the remaining samples are available, the finished
+    // motions are not.
+    size_t remaining {0}, consumed {0};
+    different = 0;
+
+    for (long long k = 0; k < samples; k++) {
+        different += !motion->state_at_sample(k, state) || !equal(state, motion->get_state_setpoint());
+
+        if (k % 97 == 0) {
+            for (long long j = k; j < samples; j += 13)
+                remaining += !motion->state_at_sample(j, state) || !equal(state, sampled[j]);
+
+            // No motion of this path lasts 400 samples.
+            if (k >= 400)
+                consumed += motion->state_at_sample(k - 400, state) || motion->state_at((k - 400) * 1e-3, state);
+        }
+
+        motion->increment_motion_sample();
+    }
+
+    std::printf("%s, while sampling: %zu current and %zu remaining samples different, %zu finished samples available\n",
+                name, different, remaining, consumed);
+
+    CHECK(different == 0);
+    CHECK(remaining == 0);
+    CHECK(consumed == 0);
+}
+
+// The planner lags one point, samples of the last segments become available when the path is planned further.
+static void check_partial() {
+    auto complete = plan(0, path().size());
+    auto partial = plan(0, 20);
+
+    long long planned {0};
+    MotionState<double, 3> state, expected;
+    while (partial->state_at_sample(planned, state))
+        planned++;
+
+    bool later {complete->state_at_sample(planned, expected)};
+
+    std::vector<Position> p {path()};
+    for (size_t k = 20; k < p.size(); k++)
+        partial->plan(p[k], 50., 1000.);
+
+    bool planned_later {partial->state_at_sample(planned, state) && equal(state, expected)};
+
+    BasicMotion<double, 3> empty(1000);
+    bool nothing {empty.state_at_sample(0, state) || empty.state_at(0, state)};
+
+    std::printf("partial: %lld samples planned, sample %lld available after planning further %d, empty motion %d\n",
+                planned, planned, planned_later, nothing);
+
+    CHECK(planned > 0);
+    CHECK(later);
+    CHECK(planned_later);
+    CHECK(!nothing);
+}
+
+int main() {
+    check_mode("transitions", 0);
+    check_mode("jerk limited", 1);
+    check_mode("blended", 2);
+    check_partial();
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,76 @@
+// A StaticMove is planned and tabulated in a constant expression. Its samples equal those of
+// BasicMotion with the same jerk limit up to the rounding of the square roots, with and without
+// coast phase and for a move which is limited by the acceleration only.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "Motion/Motion.hpp"
+#include "Motion/StaticMotion.hpp"
+#include "Check.hpp"
+
+using Position = std::array<double, 3>;
+
+constexpr StaticMove<double, 3> homing({0, 0, 0}, {0, 0, -20}, 50, 1000, 1000, 20000);
+constexpr auto table = make_sample_table<homing.size()>(homing);
+
+static_assert(table.size() == homing.size(), "one entry per sample");
+static_assert(table[0].position[2] == 0 && table[0].velocity[2] == 0, "starts at rest");
+static_assert(table[homing.size() - 1].position[2] == -20 && table[homing.size() - 1].velocity[2] == 0, "ends at rest");
+static_assert(table[homing.size() / 2].velocity[2] > -50 * (1 + 1e-9) && table[homing.size() / 2].velocity[2] < -49, "coasts");
+static_assert(table[homing.size() / 2].position[0] == 0 && table[homing.size() / 2].position[1] == 0, "straight");
+
+/**
+ * @param jerk  Jerk limit of the move, 0 is compared with a planner of which the jerk limit is never reached.
+ */
+static void check_move(const char* name, const Position& from, const Position& to, double velocity, double jerk) {
+    StaticMove<double, 3> move(from, to, velocity, 1000, 1000, jerk);
+
+    BasicMotion<double, 3> motion(1000, from);
+    motion.set_jerk_limit(jerk > 0 ? jerk : 1e15);
+    motion.plan(to, velocity, 1000.);
+    motion.plan(to, velocity, 1000., 0);
+
+    std::vector<MotionState<double, 3>> sampled;
+    bool in_progress {true};
+    while (in_progress) {
+        sampled.push_back(motion.get_state_setpoint());
+        in_progress = motion.increment_motion_sample();
+    }
+
+    // The last sample of BasicMotion evaluates the last phase one sample past its end.
+    double difference {0};
+    for (size_t k = 0; k + 1 < std::min(sampled.size(), move.size()); k++) {
+        MotionState<double, 3> s {move.state(k)};
+
+        for (size_t i = 0; i < 3; i++) {
+            difference = std::max({difference, std::fabs(s.position[i] - sampled[k].position[i]),
+                                   std::fabs(s.velocity[i] - sampled[k].velocity[i]) * 1e-3,
+                                   std::fabs(s.acceleration[i] - sampled[k].acceleration[i]) * 1e-6});
+        }
+    }
+
+    MotionState<double, 3> end {move.state(move.size() + 10)};
+
+    std::printf("%s: %zu samples, %zu samples of BasicMotion, largest difference %g, phases %d %d %d\n",
+                name, move.size(), sampled.size(), difference, move.phase(0).n, move.phase(1).n, move.phase(2).n);
+
+    CHECK(move.size() == sampled.size());
+    CHECK(difference < 1e-9);
+    CHECK(end.position == to);
+    CHECK(std::fabs(move.duration() - (move.size() - 1) * 1e-3) < 1e-12);
+}
+
+int main() {
+    MotionState<double, 3> last {table[homing.size() - 1]};
+    std::printf("table: %zu samples, end %g, coast velocity %g\n", table.size(), last.position[2], table[homing.size() / 2].velocity[2]);
+
+    check_move("jerk limited with coast", {0, 0, 0}, {0, 0, -20}, 50, 20000);
+    check_move("jerk limited without coast", {1, 2, 3}, {1.3, 2.2, 3.1}, 50, 20000);
+    check_move("acceleration limited with coast", {1, 2, 3}, {-5, 4, 10}, 50, 0);
+    check_move("acceleration limited without coast", {0, 0, 0}, {0.4, 0, 0}, 50, 0);
+
+    return CHECK_RESULT();
+}
@@ -0,0 +1,260 @@
+// ToolpathReader parses comma, whitespace and G-code lines, reads numbers exactly like strtod,
+// reads lines which span the end of a chunk, reports malformed lines with their line number and
+// plans no further ahead than feed() allows.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Motion/Motion.hpp"
+#include "Motion/ToolpathReader.hpp"
+#include "Check.hpp"
+
+using Position = std::array<double, 3>;
+
+// Temporary file holding text, closed by the destructor.
+struct TextFile {
+    explicit TextFile(const std::string& text) : file(std::tmpfile()) {
+        std::fwrite(text.data(), 1, text.size(), file);
+        std::rewind(file);
+    }
+
+    ~TextFile() {
+        std::fclose(file);
+    }
+
+    std::FILE* file;
+};
+
+static std::vector<ToolpathPoint<double, 3>> read(const std::string& text, size_t chunk_size = 1 << 16) {
+    TextFile file(text);
+    ToolpathReader<double, 3> reader(10, 100, chunk_size);
+    reader.open(file.file);
+
+    std::vector<ToolpathPoint<double, 3>> points;
+    ToolpathPoint<double, 3> p;
+    while (reader.next(p))
+        points.push_back(p);
+
+    CHECK(!reader.failed());
+    CHECK(reader.done());
+    return points;
+}
+
+static bool equal(const ToolpathPoint<double, 3>& p, const Position& position, double velocity,
+                  double acceleration, bool has_final = false, double v_final = 0) {
+    return p.position == position && p.velocity == velocity && p.acceleration == acceleration
+        && p.has_final == has_final && p.v_final == v_final;
+}
+
+static void check_formats() {
+    std::vector<ToolpathPoint<double, 3>> points {read(
+        "# header\n"
+        "1,2,3\n"
+        "\n"
+        "4 5\t6 20\n"
+        "7;8;9, 30, 300, 5\r\n"
+        "G21 (millimeters)\n"
+        "G1 X1 Y2 Z3 F600\n"
+        "g1 x4 y-5 ; comment\n"
+        "G1 Z 6 (comment) f1200\n"
+        "x7.5y8.5")};
+
+    std::printf("formats: %zu points\n", points.size());
+
+    CHECK(points.size() == 7);
+    if (points.size() != 7)
+        return;
+
+    CHECK(equal(points[0], {1, 2, 3}, 10, 100));
+    CHECK(equal(points[1], {4, 5, 6}, 20, 100));
+    CHECK(equal(points[2], {7, 8, 9}, 30, 300, true, 5));
+
+    // F is per minute, positions and the feed rate are modal.
+    CHECK(equal(points[3], {1, 2, 3}, 10, 100));
+    CHECK(equal(points[4], {4, -5, 3}, 10, 100));
+    CHECK(equal(points[5], {4, -5, 6}, 20, 100));
+    CHECK(equal(points[6], {7.5, 8.5, 6}, 20, 100));
+
+    // A feed rate per second.
+    TextFile file("G1 X1 F600\n");
+    ToolpathReader<double, 3> reader(10, 100);
+    reader.set_feed_scale(1);
+    reader.open(file.file);
+
+    ToolpathPoint<double, 3> p;
+    CHECK(reader.next(p) && p.velocity == 600);
+}
+
+static void check_numbers() {
+    const char* numbers[] {
+        "0", "-0", "+1", "0.1", "-2.5", ".5", "5.", "3.14159265358979", "123456789012345678",
+        "1e0", "1.5e3", "2E-7", "-7.25e+10", "1e22", "1e23", "1e-22", "4.9e-324", "1.7976931348623157e308",
+        "9007199254740993", "12345678901234567890", "1234567890123456789012345.678",
+        "0.00000000000000000000000000123", "000000000000000000000000042.5", "0000.000000000000000000000017",
+        "0.30000000000000004", "2.2250738585072014e-308", "123.456e-5", "1e400", "-1e-400"
+    };
+
+    size_t different {0};
+    for (const char* number : numbers) {
+        std::string line {std::string(number) + ",0," + number + "\n"};
+        std::vector<ToolpathPoint<double, 3>> points {read(line)};
+
+        double expected {std::strtod(number, nullptr)};
+        bool same {points.size() == 1
+            && std::memcmp(&points[0].position[0], &expected, sizeof(double)) == 0
+            && std::memcmp(&points[0].position[2], &expected, sizeof(double)) == 0};
+
+        if (!same)
+            std::printf("%s differs from strtod\n", number);
+        different += !same;
+    }
+
+    std::printf("numbers: %zu of %zu differ from strtod\n", different, sizeof(numbers) / sizeof(numbers[0]));
+    CHECK(different == 0);
+}
+
+static void check_chunks() {
+    std::string text;
+    for (int k = 0; k < 200; k++) {
+        char line[64];
+        if (k % 3 == 0)
+            std::snprintf(line, sizeof(line), "%d.%d, %d, %d\n", k, k % 7, -k, k * 3);
+        else
+            std::snprintf(line, sizeof(line), "G1 X%d Y%d.125 F%d\n", k, k % 11, 600 + k);
+        text += line;
+    }
+
+    std::vector<ToolpathPoint<double, 3>> expected {read(text)};
+
+    // Every chunk ends inside a line, the longest line is 21 characters.
+    size_t different {0};
+    for (size_t chunk_size : {size_t(21), size_t(22), size_t(29), size_t(64), size_t(1000)}) {
+        std::vector<ToolpathPoint<double, 3>> points {read(text, chunk_size)};
+        bool same {points.size() == expected.size()};
+
+        for (size_t k = 0; same && k < points.size(); k++)
+            same = std::memcmp(&points[k], &expected[k], sizeof(points[k])) == 0;
+
+        different += !same;
+    }
+
+    std::printf("chunks: %zu points, %zu chunk sizes differ\n", expected.size(), different);
+    CHECK(expected.size() == 200);
+    CHECK(different == 0);
+}
+
+// Reads until the end or an error, returns the amount of points.
+static size_t read_failing(const std::string& text, size_t chunk_size, size_t& line_number) {
+    TextFile file(text);
+    ToolpathReader<double, 3> reader(10, 100, chunk_size);
+    reader.open(file.file);
+
+    size_t count {0};
+    ToolpathPoint<double, 3> p;
+    while (reader.next(p))
+        count++;
+
+    CHECK(reader.failed());
+    CHECK(reader.done());
+    CHECK(!reader.next(p));
+
+    line_number = reader.line_number();
+    return count;
+}
+
+static void check_errors() {
+    size_t line {0};
+
+    size_t count {read_failing("1,2,3\n4,5,6\n1234567890,1234567890,1\n7,8,9\n", 16, line)};
+    std::printf("line too long: %zu points, line %zu\n", count, line);
+    CHECK(count == 2 && line == 3);
+
+    const char* invalid[] {
+        "1,2,3\n# comment\n1,2,x\n4,5,6\n",
+        "1,2,3\n\n\n1,2\n",
+        "1,2,3\n1,2,3,4,5,6,7\n",
+        "G1 X1\nG1 X\n",
+        "G1 X1\nG1 X1 *2\n",
+    };
+    const size_t lines[] {3, 4, 2, 2, 2};
+
+    for (size_t i = 0; i < sizeof(lines) / sizeof(lines[0]); i++) {
+        count = read_failing(invalid[i], 1 << 16, line);
+        std::printf("invalid line: %zu points, line %zu\n", count, line);
+        CHECK(count == 1 && line == lines[i]);
+    }
+}
+
+// feed() stops at the amount of queued samples or a full queue, the sampled trajectory equals
+// the toolpath planned up front.
+template <typename M>
+static void check_feed(const char* name, long long max_samples, size_t max_moves) {
+    std::string text;
+    for (int k = 1; k <= 300; k++)
+        text += std::to_string(k % 3 == 0 ? k * 0.5 : k * 0.5 + 0.25) + " " + std::to_string(k % 7) + " 0\n";
+
+    // The last point is planned again to stop at it.
+    TextFile file(text + "150 6 0 50 1000 0\n");
+
+    BasicMotion<double, 3> reference(1000);
+    {
+        ToolpathReader<double, 3> reader(50, 1000);
+        TextFile copy(text + "150 6 0 50 1000 0\n");
+        reader.open(copy.file);
+        reader.feed(reference, 1LL << 62);
+        CHECK(reader.done() && !reader.failed());
+    }
+
+    auto motion = std::make_unique<M>(1000);
+    ToolpathReader<double, 3> reader(50, 1000);
+    reader.open(file.file);
+
+    std::vector<MotionState<double, 3>> sampled, expected;
+    long long queued {0};
+    size_t calls {0}, moves {0};
+    bool in_progress {true};
+
+    while (in_progress) {
+        if (reader.feed(*motion, max_samples) > 0)
+            calls++;
+
+        // The last plan call may queue a move beyond the limit.
+        queued = std::max(queued, static_cast<long long>(motion->motion_length));
+        moves = std::max(moves, static_cast<size_t>(motion->motion_queue_size()));
+
+        sampled.push_back(motion->get_state_setpoint());
+        in_progress = motion->increment_motion_sample() || !reader.done();
+    }
+
+    in_progress = true;
+    while (in_progress) {
+        expected.push_back(reference.get_state_setpoint());
+        in_progress = reference.increment_motion_sample();
+    }
+
+    bool equal {sampled.size() == expected.size()
+        && std::memcmp(sampled.data(), expected.data(), expected.size() * sizeof(MotionState<double, 3>)) == 0};
+
+    std::printf("%s: %zu samples, %zu feed calls, at most %lld samples and %zu moves queued, equal to planning up front %d\n",
+                name, sampled.size(), calls, queued, moves, equal);
+
+    CHECK(calls > 10);
+    CHECK(queued < 2 * max_samples);
+    CHECK(moves <= max_moves);
+    CHECK(equal);
+}
+
+int main() {
+    check_formats();
+    check_numbers();
+    check_chunks();
+    check_errors();
+    check_feed<BasicMotion<double, 3>>("feed 200 samples", 200, 20);
+    check_feed<BasicMotion<double, 3, FixedQueue<MoveRecord<double, 3>, 4>>>("feed into a queue of 4 moves", 1LL << 40, 4);
+
+    return CHECK_RESULT();
+}